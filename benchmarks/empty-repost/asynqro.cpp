@@ -71,6 +71,9 @@ int main()
         asynqro::tasks::TasksDispatcher::instance()->preHeatPool();
 #endif
         asynqro::tasks::TasksDispatcher::instance()->setIdleLoopsAmount(IDLE_AMOUNT);
+#if defined(WORK_STEALING) && WORK_STEALING
+        asynqro::tasks::TasksDispatcher::instance()->setWorkStealingEnabled(true);
+#endif
         std::cout << "***asynqro***" << std::endl;
 
         std::vector<asynqro::Future<bool, std::string>> waiters;
@@ -0,0 +1,110 @@
+#define ASYNQRO_DEBUG_COUNT_OBJECTS
+#include "asynqro/asynqro"
+
+#include <chrono>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+#ifndef JOBS_COUNT
+#    define JOBS_COUNT 100000
+#endif
+
+#ifndef CHAIN_LENGTH
+#    define CHAIN_LENGTH 10
+#endif
+
+// Creates and destroys lots of short-lived futures in map/flatMap chains.
+// Reference part emulates previous layout (shared_ptr to state created with make_shared and copied to callbacks).
+// This benchmark is not supposed for comparison with other systems, only to track Future allocation overhead.
+namespace {
+using TestFuture = asynqro::Future<int, std::string>;
+using TestPromise = asynqro::Promise<int, std::string>;
+
+struct SharedState
+{
+    char storage[sizeof(asynqro::detail::FutureData<int, std::string>)];
+    std::vector<std::function<void(int)>> callbacks;
+};
+
+long long now()
+{
+    return std::chrono::high_resolution_clock::now().time_since_epoch().count();
+}
+} // namespace
+
+int main()
+{
+    std::cout << "Benchmark future allocation: " << JOBS_COUNT << "/" << CHAIN_LENGTH << std::endl;
+    {
+        std::cout << "***reference shared_ptr***" << std::endl;
+        long long sum = 0;
+        long long begin = now();
+        for (int job = 0; job < JOBS_COUNT; ++job) {
+            auto root = std::make_shared<SharedState>();
+            auto current = root;
+            for (int i = 0; i < CHAIN_LENGTH; ++i) {
+                auto next = std::make_shared<SharedState>();
+                current->callbacks.emplace_back([next, &sum](int x) {
+                    sum += x;
+                    for (auto &f : next->callbacks)
+                        f(x + 1);
+                });
+                current = next;
+            }
+            current.reset();
+            for (auto &f : root->callbacks)
+                f(job);
+        }
+        long long end = now();
+        std::cout << "sum " << sum << "; done in " << (double)(end - begin) / (double)1000000 << " ms" << std::endl;
+    }
+    {
+        std::cout << "***asynqro map***" << std::endl;
+        long long sum = 0;
+        int_fast64_t pooledBefore = asynqro::instantPooledAllocations();
+        int_fast64_t nonPooledBefore = asynqro::instantNonPooledAllocations();
+        long long begin = now();
+        for (int job = 0; job < JOBS_COUNT; ++job) {
+            TestPromise promise;
+            TestFuture current = promise.future();
+            for (int i = 0; i < CHAIN_LENGTH; ++i) {
+                current = current.map([&sum](int x) {
+                    sum += x;
+                    return x + 1;
+                });
+            }
+            promise.success(job);
+        }
+        long long end = now();
+        std::cout << "sum " << sum << "; done in " << (double)(end - begin) / (double)1000000 << " ms; "
+                  << "pooled allocations " << asynqro::instantPooledAllocations() - pooledBefore << "; "
+                  << "non-pooled allocations " << asynqro::instantNonPooledAllocations() - nonPooledBefore
+                  << "; futures alive " << asynqro::instantFuturesUsage() << std::endl;
+    }
+    {
+        std::cout << "***asynqro flatMap***" << std::endl;
+        long long sum = 0;
+        int_fast64_t pooledBefore = asynqro::instantPooledAllocations();
+        int_fast64_t nonPooledBefore = asynqro::instantNonPooledAllocations();
+        long long begin = now();
+        for (int job = 0; job < JOBS_COUNT; ++job) {
+            TestPromise promise;
+            TestFuture current = promise.future();
+            for (int i = 0; i < CHAIN_LENGTH; ++i) {
+                current = current.flatMap([&sum](int x) {
+                    sum += x;
+                    return TestFuture::successful(x + 1);
+                });
+            }
+            promise.success(job);
+        }
+        long long end = now();
+        std::cout << "sum " << sum << "; done in " << (double)(end - begin) / (double)1000000 << " ms; "
+                  << "pooled allocations " << asynqro::instantPooledAllocations() - pooledBefore << "; "
+                  << "non-pooled allocations " << asynqro::instantNonPooledAllocations() - nonPooledBefore
+                  << "; futures alive " << asynqro::instantFuturesUsage() << std::endl;
+    }
+    return 0;
+}
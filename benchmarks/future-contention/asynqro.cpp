@@ -0,0 +1,70 @@
+#include "asynqro/asynqro"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifndef CONCURRENCY
+#    define CONCURRENCY 4
+#endif
+
+#ifndef JOBS_COUNT
+#    define JOBS_COUNT 10000
+#endif
+
+#ifndef CALLBACKS_COUNT
+#    define CALLBACKS_COUNT 100
+#endif
+
+// N threads register callbacks on the same future while another thread fills it.
+// This benchmark is not supposed for comparison with other systems, only to track Future overhead under contention.
+int main()
+{
+    std::cout << "Benchmark future contention: " << CONCURRENCY << "/" << JOBS_COUNT << "/" << CALLBACKS_COUNT
+              << std::endl;
+    {
+        std::cout << "***asynqro***" << std::endl;
+        std::atomic_llong called{0};
+        long long registrationTime = 0;
+        long long begin = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        for (int job = 0; job < JOBS_COUNT; ++job) {
+            asynqro::Promise<int, std::string> promise;
+            auto future = promise.future();
+            std::atomic_int started{0};
+            std::atomic_llong jobRegistrationTime{0};
+            std::vector<std::thread> registrators;
+            registrators.reserve(CONCURRENCY);
+            for (int i = 0; i < CONCURRENCY; ++i) {
+                registrators.emplace_back([future, &called, &started, &jobRegistrationTime]() {
+                    started.fetch_add(1, std::memory_order_relaxed);
+                    while (started.load(std::memory_order_relaxed) <= CONCURRENCY) {
+                    }
+                    long long innerBegin = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+                    for (int j = 0; j < CALLBACKS_COUNT; ++j)
+                        future.onSuccess([&called](int) { called.fetch_add(1, std::memory_order_relaxed); });
+                    jobRegistrationTime.fetch_add(std::chrono::high_resolution_clock::now().time_since_epoch().count()
+                                                      - innerBegin,
+                                                  std::memory_order_relaxed);
+                });
+            }
+            std::thread filler([promise, &started]() {
+                started.fetch_add(1, std::memory_order_relaxed);
+                while (started.load(std::memory_order_relaxed) <= CONCURRENCY) {
+                }
+                std::this_thread::yield();
+                promise.success(42);
+            });
+            for (auto &t : registrators)
+                t.join();
+            filler.join();
+            registrationTime += jobRegistrationTime.load();
+        }
+        long long end = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        std::cout << "registered " << called.load() << " in " << (double)(end - begin) / (double)1000000 << " ms; "
+                  << "registration " << (double)registrationTime / (double)(CONCURRENCY * 1000000) << " ms"
+                  << std::endl;
+    }
+    return 0;
+}
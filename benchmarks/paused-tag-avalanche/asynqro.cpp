@@ -0,0 +1,79 @@
+#include "asynqro/asynqro"
+
+#include <atomic>
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#ifndef JOBS_COUNT
+#    define JOBS_COUNT 100000
+#endif
+
+#ifndef PAUSED_JOBS_COUNT
+#    define PAUSED_JOBS_COUNT 100000
+#endif
+
+#ifndef IDLE_AMOUNT
+#    define IDLE_AMOUNT 10000
+#endif
+
+#define PAUSED_TAG 1
+
+// Same as empty-avalanche, but with backlog of tasks in paused custom tag that stays in queue during whole run.
+// Shows if scheduling of other tasks depends on amount of tasks that can't be run.
+int main()
+{
+    std::cout << "Benchmark job avalanche with paused backlog (empty): " << JOBS_COUNT << "/" << PAUSED_JOBS_COUNT
+              << std::endl;
+    {
+#if defined(WITH_PREHEAT) && WITH_PREHEAT
+        asynqro::tasks::TasksDispatcher::instance()->preHeatPool();
+#endif
+        asynqro::tasks::TasksDispatcher::instance()->setIdleLoopsAmount(IDLE_AMOUNT);
+        asynqro::tasks::TasksDispatcher::instance()->addCustomTag(PAUSED_TAG, 1);
+        asynqro::tasks::TasksDispatcher::instance()->pauseCustomTag(PAUSED_TAG);
+        std::atomic_int pausedDone{0};
+        for (int id = 0; id < PAUSED_JOBS_COUNT; ++id) {
+            asynqro::tasks::runAndForget([&pausedDone]() { ++pausedDone; }, asynqro::tasks::TaskType::Custom,
+                                         PAUSED_TAG);
+        }
+
+        std::cout << "***asynqro***" << std::endl;
+        long long *finished = new long long[JOBS_COUNT];
+        memset(finished, 0, sizeof(long long) * JOBS_COUNT);
+        long long begin = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+        for (int id = 0; id < JOBS_COUNT; ++id) {
+#if defined(WITH_FUTURES) && WITH_FUTURES
+            asynqro::tasks::run
+#else
+            asynqro::tasks::runAndForget
+#endif
+                ([resultPlace = &finished[id]]() {
+                    *resultPlace = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+                });
+        }
+        std::this_thread::sleep_for(std::chrono::microseconds{JOBS_COUNT * 10});
+        bool done = false;
+        long long max = 0;
+        while (!done) {
+            std::this_thread::sleep_for(std::chrono::microseconds{JOBS_COUNT});
+            done = true;
+            max = 0;
+            for (int i = 0; i < JOBS_COUNT; ++i) {
+                if (!finished[i]) {
+                    done = false;
+                    break;
+                }
+                if (finished[i] > max)
+                    max = finished[i];
+            }
+        }
+        std::cout << "processed " << JOBS_COUNT << " in " << (double)(max - begin) / (double)1000000 << " ms"
+                  << std::endl;
+
+        asynqro::tasks::TasksDispatcher::instance()->resumeCustomTag(PAUSED_TAG);
+        while (pausedDone < PAUSED_JOBS_COUNT)
+            std::this_thread::sleep_for(std::chrono::milliseconds{1});
+    }
+    return 0;
+}
@@ -0,0 +1,345 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_ALGORITHMS_H
+#define ASYNQRO_ALGORITHMS_H
+
+#include "asynqro/future.h"
+#include "asynqro/tasks.h"
+
+#include <algorithm>
+#include <functional>
+#include <optional>
+#include <utility>
+#include <vector>
+
+namespace asynqro {
+namespace tasks {
+namespace algorithms {
+namespace detail {
+using namespace asynqro::tasks::detail;
+
+// Amount of samples taken for each bucket in sort to choose splitters
+constexpr int64_t SORT_SAMPLES_PER_BUCKET = 16;
+
+// Runs body(cluster) for each cluster in [0, count) in the same way clusteredRun does and waits for all of them
+template <typename Runner, typename Body>
+std::optional<typename Runner::Info::PlainFailure> forEachCluster(int64_t count, TaskType type, int32_t tag,
+                                                                  TaskPriority priority, Body &&body) noexcept
+{
+    auto chunkBody = [&body](int64_t begin, int64_t end) {
+        for (int64_t cluster = begin; cluster < end && !hasLastFailure(); ++cluster)
+            body(cluster);
+    };
+    return runChunked<Runner>(count, 1, type, tag, priority, chunkBody);
+}
+
+// Stable split of data by predicate. Predicate is called only once for each element, its results are stored and
+// are used on the second pass that moves elements to their final places computed from per-cluster counters.
+template <bool keepRejected, typename Runner, typename C, typename Predicate>
+std::optional<typename Runner::Info::PlainFailure> split(C &data, Predicate &predicate, C &selected, C &rejected,
+                                                         int64_t minClusterSize, TaskType type, int32_t tag,
+                                                         TaskPriority priority)
+{
+    Clusters clusters(static_cast<int64_t>(data.size()), minClusterSize, type, tag);
+    std::vector<uint8_t> flags(data.size());
+    std::vector<int64_t> selectedOffsets(static_cast<size_t>(clusters.count));
+    auto failure = forEachCluster<Runner>(clusters.count, type, tag, priority, [&](int64_t cluster) {
+        int64_t count = 0;
+        for (int64_t i = clusters.begin(cluster); i < clusters.end(cluster) && !hasLastFailure(); ++i) {
+            flags[i] = predicate(data[i]) ? 1 : 0;
+            count += flags[i];
+        }
+        selectedOffsets[cluster] = count;
+    });
+    if (failure)
+        return failure;
+
+    int64_t selectedCount = 0;
+    for (auto &offset : selectedOffsets)
+        selectedCount += std::exchange(offset, selectedCount);
+    selected.resize(selectedCount);
+    if constexpr (keepRejected)
+        rejected.resize(data.size() - selectedCount);
+
+    return forEachCluster<Runner>(clusters.count, type, tag, priority, [&](int64_t cluster) {
+        int64_t selectedOffset = selectedOffsets[cluster];
+        int64_t rejectedOffset = clusters.begin(cluster) - selectedOffset;
+        for (int64_t i = clusters.begin(cluster); i < clusters.end(cluster); ++i) {
+            if (flags[i])
+                selected[selectedOffset++] = std::move(data[i]);
+            else if constexpr (keepRejected)
+                rejected[rejectedOffset++] = std::move(data[i]);
+        }
+    });
+}
+
+// Scans each cluster in place and returns total of each cluster
+template <typename Runner, typename C, typename Op, typename T = InnerType_T<C>>
+std::optional<typename Runner::Info::PlainFailure> scanClusters(C &data, Op &op, const Clusters &clusters,
+                                                                std::vector<std::optional<T>> &totals, TaskType type,
+                                                                int32_t tag, TaskPriority priority)
+{
+    return forEachCluster<Runner>(clusters.count, type, tag, priority, [&](int64_t cluster) {
+        int64_t begin = clusters.begin(cluster);
+        int64_t end = clusters.end(cluster);
+        for (int64_t i = begin + 1; i < end && !hasLastFailure(); ++i)
+            data[i] = op(data[i - 1], data[i]);
+        totals[cluster].emplace(data[end - 1]);
+    });
+}
+} // namespace detail
+
+// Parallel sample sort. Splitters are chosen from evenly taken samples, then each cluster distributes
+// its elements to buckets and buckets are sorted independently. Sort is not stable.
+template <typename Runner = tasks::detail::DefaultRunner, typename C, typename Compare = std::less<>,
+          typename T = tasks::detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_r_v<bool, Compare, const T &, const T &>>>
+Future<std::decay_t<C>, typename Runner::Info::PlainFailure>
+sort(C &&data, Compare &&comp = Compare(), int64_t minClusterSize = 1, TaskType type = TaskType::Intensive,
+     int32_t tag = 0, TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    using Container = std::decay_t<C>;
+    if (data.size() < 2)
+        return Future<Container, typename Runner::Info::PlainFailure>::successful(std::forward<C>(data));
+
+    return Runner::run(
+        [data = std::forward<C>(data), comp = std::forward<Compare>(comp), minClusterSize, type, tag,
+         priority]() mutable -> Container {
+            auto amount = static_cast<int64_t>(data.size());
+            tasks::detail::Clusters clusters(amount, minClusterSize, type, tag);
+            if (clusters.count == 1) {
+                std::sort(data.begin(), data.end(), comp);
+                return std::move(data);
+            }
+
+            int64_t bucketsCount = clusters.count;
+            int64_t samplesCount = std::min(amount, bucketsCount * detail::SORT_SAMPLES_PER_BUCKET);
+            std::vector<T> splitters;
+            splitters.reserve(static_cast<size_t>(samplesCount));
+            for (int64_t i = 0; i < samplesCount; ++i)
+                splitters.push_back(data[i * amount / samplesCount]);
+            std::sort(splitters.begin(), splitters.end(), comp);
+            for (int64_t i = 1; i < bucketsCount; ++i)
+                splitters[i - 1] = std::move(splitters[i * samplesCount / bucketsCount]);
+            splitters.resize(static_cast<size_t>(bucketsCount - 1));
+
+            std::vector<int32_t> buckets(data.size());
+            std::vector<int64_t> offsets(static_cast<size_t>(clusters.count * bucketsCount));
+            auto failure = detail::forEachCluster<Runner>(clusters.count, type, tag, priority, [&](int64_t cluster) {
+                std::vector<int64_t> counts(static_cast<size_t>(bucketsCount));
+                for (int64_t i = clusters.begin(cluster); i < clusters.end(cluster); ++i) {
+                    auto bucket = std::upper_bound(splitters.cbegin(), splitters.cend(), data[i], comp)
+                                  - splitters.cbegin();
+                    buckets[i] = static_cast<int32_t>(bucket);
+                    ++counts[bucket];
+                }
+                std::copy(counts.cbegin(), counts.cend(), offsets.begin() + cluster * bucketsCount);
+            });
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+
+            // Offsets are ordered by bucket first, so each bucket is a contiguous range in result
+            std::vector<int64_t> bucketBegins(static_cast<size_t>(bucketsCount + 1));
+            int64_t offset = 0;
+            for (int64_t bucket = 0; bucket < bucketsCount; ++bucket) {
+                bucketBegins[bucket] = offset;
+                for (int64_t cluster = 0; cluster < clusters.count; ++cluster)
+                    offset += std::exchange(offsets[cluster * bucketsCount + bucket], offset);
+            }
+            bucketBegins[bucketsCount] = amount;
+
+            Container result;
+            result.resize(data.size());
+            failure = detail::forEachCluster<Runner>(clusters.count, type, tag, priority, [&](int64_t cluster) {
+                auto clusterOffsets = offsets.begin() + cluster * bucketsCount;
+                for (int64_t i = clusters.begin(cluster); i < clusters.end(cluster); ++i)
+                    result[clusterOffsets[buckets[i]]++] = std::move(data[i]);
+            });
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+
+            failure = detail::forEachCluster<Runner>(bucketsCount, type, tag, priority, [&](int64_t bucket) {
+                std::sort(result.begin() + bucketBegins[bucket], result.begin() + bucketBegins[bucket + 1], comp);
+            });
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return result;
+        },
+        type, tag, priority);
+}
+
+// Parallel prefix sum: result[i] = op(data[0], ..., data[i]). Op should be associative.
+// Each cluster is scanned independently and then totals of preceding clusters are applied to it.
+template <typename Runner = tasks::detail::DefaultRunner, typename C, typename Op = std::plus<>,
+          typename T = tasks::detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<Op, const T &, const T &>>>
+Future<std::decay_t<C>, typename Runner::Info::PlainFailure>
+inclusiveScan(C &&data, Op &&op = Op(), int64_t minClusterSize = 1, TaskType type = TaskType::Intensive,
+              int32_t tag = 0, TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    using Container = std::decay_t<C>;
+    if (data.empty())
+        return Future<Container, typename Runner::Info::PlainFailure>::successful(std::forward<C>(data));
+
+    return Runner::run(
+        [data = std::forward<C>(data), op = std::forward<Op>(op), minClusterSize, type, tag,
+         priority]() mutable -> Container {
+            tasks::detail::Clusters clusters(static_cast<int64_t>(data.size()), minClusterSize, type, tag);
+            std::vector<std::optional<T>> totals(static_cast<size_t>(clusters.count));
+            auto failure = detail::scanClusters<Runner>(data, op, clusters, totals, type, tag, priority);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            if (clusters.count == 1)
+                return std::move(data);
+
+            for (size_t i = 1; i < totals.size(); ++i)
+                totals[i] = op(*totals[i - 1], *totals[i]);
+            failure = detail::forEachCluster<Runner>(clusters.count - 1, type, tag, priority, [&](int64_t prev) {
+                const T &carry = *totals[prev];
+                for (int64_t i = clusters.begin(prev + 1); i < clusters.end(prev + 1) && !detail::hasLastFailure(); ++i)
+                    data[i] = op(carry, data[i]);
+            });
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return std::move(data);
+        },
+        type, tag, priority);
+}
+
+// Parallel exclusive prefix sum: result[0] = init, result[i] = op(init, data[0], ..., data[i - 1]).
+// Op should be associative.
+template <typename Runner = tasks::detail::DefaultRunner, typename C, typename Op = std::plus<>,
+          typename T = tasks::detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<Op, const T &, const T &>>>
+Future<std::decay_t<C>, typename Runner::Info::PlainFailure>
+exclusiveScan(C &&data, const tasks::detail::InnerType_T<std::decay_t<C>> &init, Op &&op = Op(),
+              int64_t minClusterSize = 1, TaskType type = TaskType::Intensive, int32_t tag = 0,
+              TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    using Container = std::decay_t<C>;
+    if (data.empty())
+        return Future<Container, typename Runner::Info::PlainFailure>::successful(std::forward<C>(data));
+
+    return Runner::run(
+        [data = std::forward<C>(data), init, op = std::forward<Op>(op), minClusterSize, type, tag,
+         priority]() mutable -> Container {
+            tasks::detail::Clusters clusters(static_cast<int64_t>(data.size()), minClusterSize, type, tag);
+            std::vector<std::optional<T>> totals(static_cast<size_t>(clusters.count));
+            auto failure = detail::scanClusters<Runner>(data, op, clusters, totals, type, tag, priority);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+
+            // Totals are replaced with carries for each cluster
+            T carry = init;
+            for (auto &total : totals) {
+                T next = op(carry, *total);
+                total.emplace(std::move(carry));
+                carry = std::move(next);
+            }
+            failure = detail::forEachCluster<Runner>(clusters.count, type, tag, priority, [&](int64_t cluster) {
+                const T &clusterCarry = *totals[cluster];
+                int64_t begin = clusters.begin(cluster);
+                for (int64_t i = clusters.end(cluster) - 1; i > begin && !detail::hasLastFailure(); --i)
+                    data[i] = op(clusterCarry, data[i - 1]);
+                data[begin] = clusterCarry;
+            });
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return std::move(data);
+        },
+        type, tag, priority);
+}
+
+// Stable parallel partition. Returns pair of containers with elements that satisfy predicate and all others.
+template <typename Runner = tasks::detail::DefaultRunner, typename C, typename Predicate,
+          typename T = tasks::detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<Predicate, const T &>>>
+Future<std::pair<std::decay_t<C>, std::decay_t<C>>, typename Runner::Info::PlainFailure>
+partition(C &&data, Predicate &&predicate, int64_t minClusterSize = 1, TaskType type = TaskType::Intensive,
+          int32_t tag = 0, TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    using Container = std::decay_t<C>;
+    using Result = std::pair<Container, Container>;
+    if (data.empty())
+        return Future<Result, typename Runner::Info::PlainFailure>::successful(Result());
+
+    return Runner::run(
+        [data = std::forward<C>(data), predicate = std::forward<Predicate>(predicate), minClusterSize, type, tag,
+         priority]() mutable -> Result {
+            Result result;
+            auto failure = detail::split<true, Runner>(data, predicate, result.first, result.second, minClusterSize,
+                                                       type, tag, priority);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return result;
+        },
+        type, tag, priority);
+}
+
+// Parallel stream compaction. Returns container with elements that satisfy predicate in their original order.
+template <typename Runner = tasks::detail::DefaultRunner, typename C, typename Predicate,
+          typename T = tasks::detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<Predicate, const T &>>>
+Future<std::decay_t<C>, typename Runner::Info::PlainFailure>
+copyIf(C &&data, Predicate &&predicate, int64_t minClusterSize = 1, TaskType type = TaskType::Intensive,
+       int32_t tag = 0, TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    using Container = std::decay_t<C>;
+    if (data.empty())
+        return Future<Container, typename Runner::Info::PlainFailure>::successful(Container());
+
+    return Runner::run(
+        [data = std::forward<C>(data), predicate = std::forward<Predicate>(predicate), minClusterSize, type, tag,
+         priority]() mutable -> Container {
+            Container result;
+            Container unused;
+            auto failure = detail::split<false, Runner>(data, predicate, result, unused, minClusterSize, type, tag,
+                                                        priority);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return result;
+        },
+        type, tag, priority);
+}
+
+// Same as clusteredReduce, but with std::transform_reduce order of arguments
+template <typename Runner = tasks::detail::DefaultRunner, typename C, typename Acc, typename ReduceFn,
+          typename TransformFn, typename T = tasks::detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<TransformFn, T> && std::is_invocable_v<ReduceFn, Acc, Acc>>>
+Future<Acc, typename Runner::Info::PlainFailure>
+transformReduce(C &&data, Acc identity, ReduceFn &&reduceFn, TransformFn &&transformFn, int64_t minClusterSize = 1,
+                TaskType type = TaskType::Intensive, int32_t tag = 0,
+                TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    return clusteredReduce<Runner>(std::forward<C>(data), std::forward<TransformFn>(transformFn),
+                                   std::forward<ReduceFn>(reduceFn), std::move(identity), minClusterSize, type, tag,
+                                   priority);
+}
+
+} // namespace algorithms
+} // namespace tasks
+} // namespace asynqro
+
+#endif // ASYNQRO_ALGORITHMS_H
@@ -0,0 +1,280 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_COROUTINES_H
+#define ASYNQRO_COROUTINES_H
+
+#include "asynqro/future.h"
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#    define ASYNQRO_COROUTINES_SUPPORT
+
+#    include <atomic>
+#    include <coroutine>
+#    include <type_traits>
+#    include <utility>
+
+namespace asynqro {
+namespace detail {
+// Awaits Future inside of Future-returning coroutine.
+// If awaited Future fails coroutine is not resumed and its own Future is failed with the same reason.
+// Awaited Future is not owned by coroutine while it is suspended, so abandoned Futures don't keep frames alive.
+template <typename T, typename FailureT, typename OuterPromise>
+struct FutureAwaiter
+{
+    using Data = FutureData<T, FailureT>;
+    using ValueStorage = typename Data::ValueStorage;
+
+    // Marks arrival of continuation side even if continuation was destroyed without being called
+    class ArrivalGuard
+    {
+    public:
+        explicit ArrivalGuard(FutureAwaiter *awaiter) noexcept : m_awaiter(awaiter) {}
+        ArrivalGuard(const ArrivalGuard &) = delete;
+        ArrivalGuard(ArrivalGuard &&other) noexcept : m_awaiter(std::exchange(other.m_awaiter, nullptr)) {}
+        ArrivalGuard &operator=(const ArrivalGuard &) = delete;
+        ArrivalGuard &operator=(ArrivalGuard &&) = delete;
+        ~ArrivalGuard()
+        {
+            if (m_awaiter && m_awaiter->arrive())
+                m_awaiter->proceed();
+        }
+        FutureAwaiter *disarm() noexcept { return std::exchange(m_awaiter, nullptr); }
+
+    private:
+        FutureAwaiter *m_awaiter;
+    };
+
+    FutureAwaiter(OuterPromise *outer, Future<T, FailureT> &&future) noexcept
+        : m_outer(outer), m_future(std::move(future))
+    {}
+
+    bool await_ready() const noexcept { return m_future.isSucceeded() && !m_outer->isInterrupted(); }
+
+    // Both this method and continuation mark their arrival and the one that comes last decides what to do next
+    bool await_suspend(std::coroutine_handle<OuterPromise>) noexcept
+    {
+        {
+            Future<T, FailureT> awaited = std::move(m_future);
+            try {
+                awaited.addContinuation(
+                    [guard = ArrivalGuard(this), source = awaited.d.get()](const ValueStorage &) mutable noexcept {
+                        FutureAwaiter *self = guard.disarm();
+                        self->m_source = IntrusivePtr<Data>(source);
+                        if (self->arrive())
+                            self->proceed();
+                    });
+            } catch (const std::exception &e) {
+                m_outer->fail(exceptionFailure<typename OuterPromise::Failure>(e));
+            } catch (...) {
+                m_outer->fail(exceptionFailure<typename OuterPromise::Failure>());
+            }
+        }
+        if (!arrive())
+            return true;
+        if (canResume())
+            return false;
+        stop();
+        return true;
+    }
+
+    T await_resume() const
+    {
+        const ValueStorage &value = m_source ? m_source->value : m_future.d->value;
+        return std::get<1>(value);
+    }
+
+private:
+    bool arrive() noexcept { return m_arrived.exchange(true, std::memory_order_acq_rel); }
+    bool canResume() const noexcept
+    {
+        return m_source && m_source->value.index() == 1 && !m_outer->isInterrupted();
+    }
+
+    void proceed() noexcept
+    {
+        if (canResume())
+            std::coroutine_handle<OuterPromise>::from_promise(*m_outer).resume();
+        else
+            stop();
+    }
+
+    // Coroutine will not be resumed anymore, its frame will be destroyed when last Future referencing it is gone
+    void stop() noexcept
+    {
+        if (m_source && m_source->value.index() == 2)
+            m_outer->fail(std::get<2>(m_source->value));
+        m_source = IntrusivePtr<Data>();
+        m_outer->deref();
+    }
+
+    OuterPromise *m_outer;
+    Future<T, FailureT> m_future;
+    IntrusivePtr<Data> m_source;
+    std::atomic_bool m_arrived{false};
+};
+
+// Promise type for coroutines that return Future or CancelableFuture.
+// Coroutine frame holds future state itself, so each coroutine call is a single (pooled) allocation.
+template <typename T, typename FailureT, typename Result>
+struct CoroutinePromise : public FutureData<T, FailureT>
+{
+    using Failure = FailureT;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept { return false; }
+        void await_suspend(std::coroutine_handle<CoroutinePromise> handle) noexcept { handle.promise().deref(); }
+        void await_resume() const noexcept {}
+    };
+
+    CoroutinePromise() noexcept
+    {
+        this->releaseHook = &CoroutinePromise::destroyFrame;
+        // Reference that belongs to running coroutine, it is released when coroutine finishes or is stopped
+        this->ref();
+    }
+
+    Result get_return_object() noexcept
+    {
+        if constexpr (std::is_same_v<Result, Future<T, FailureT>>)
+            return future();
+        else
+            return Result(Promise<T, FailureT>(future()));
+    }
+
+    std::suspend_never initial_suspend() const noexcept { return {}; }
+    FinalAwaiter final_suspend() const noexcept { return {}; }
+
+    void return_value(const T &value) noexcept
+    {
+        invalidateLastFailure();
+        future().fillSuccess(value);
+    }
+    void return_value(T &&value) noexcept
+    {
+        invalidateLastFailure();
+        future().fillSuccess(std::move(value));
+    }
+    void return_value(WithFailure<FailureT> &&failure) noexcept
+    {
+        invalidateLastFailure();
+        // Same conversion as for regular transformations, fillSuccess() takes failure from it
+        T value = std::move(failure);
+        future().fillSuccess(std::move(value));
+    }
+
+    void unhandled_exception() noexcept
+    {
+        try {
+            throw;
+        } catch (const std::exception &e) {
+            fail(exceptionFailure<FailureT>(e));
+        } catch (...) {
+            fail(exceptionFailure<FailureT>());
+        }
+    }
+
+    // Futures are taken by value and moved out to awaiter, so temporaries kept in frame don't hold awaited state
+    template <typename U, typename OtherFailure>
+    FutureAwaiter<U, OtherFailure, CoroutinePromise> await_transform(Future<U, OtherFailure> future) noexcept
+    {
+        static_assert(std::is_convertible_v<OtherFailure, FailureT>,
+                      "Awaited Future failure should be convertible to coroutine Future failure");
+        return FutureAwaiter<U, OtherFailure, CoroutinePromise>(this, std::move(future));
+    }
+    template <typename U, typename OtherFailure>
+    FutureAwaiter<U, OtherFailure, CoroutinePromise> await_transform(CancelableFuture<U, OtherFailure> future) noexcept
+    {
+        CancelableFuture<U, OtherFailure> awaited = std::move(future);
+        return await_transform(awaited.future());
+    }
+    template <typename Awaitable,
+              typename = std::enable_if_t<!IsSpecialization_V<std::decay_t<Awaitable>, Future>
+                                          && !IsSpecialization_V<std::decay_t<Awaitable>, CancelableFuture>>>
+    Awaitable &&await_transform(Awaitable &&awaitable) noexcept
+    {
+        return std::forward<Awaitable>(awaitable);
+    }
+
+    bool isInterrupted() const noexcept
+    {
+        return (this->state.load(std::memory_order_acquire) & FUTURE_STATE_MASK) != NotCompletedFuture;
+    }
+    void fail(const FailureT &failure) noexcept { future().fillFailure(failure); }
+
+private:
+    Future<T, FailureT> future() noexcept { return Future<T, FailureT>(IntrusivePtr<FutureData<T, FailureT>>(this)); }
+
+    static void destroyFrame(FutureData<T, FailureT> *data) noexcept
+    {
+        std::coroutine_handle<CoroutinePromise>::from_promise(*static_cast<CoroutinePromise *>(data)).destroy();
+    }
+};
+} // namespace detail
+
+namespace tasks {
+// Awaitable that continues coroutine in specified subpool of tasks dispatcher.
+// Nothing is posted if coroutine is already running in this subpool.
+class ResumeOn
+{
+public:
+    ResumeOn(TaskType type, int32_t tag, TaskPriority priority) noexcept : m_type(type), m_tag(tag), m_priority(priority)
+    {}
+
+    bool await_ready() const noexcept { return detail::isCurrentWorkerInSubPool(m_type, m_tag); }
+    void await_suspend(std::coroutine_handle<> handle) const noexcept
+    {
+        detail::postContinuation([handle]() { handle.resume(); }, m_type, m_tag, m_priority);
+    }
+    void await_resume() const noexcept {}
+
+private:
+    TaskType m_type;
+    int32_t m_tag;
+    TaskPriority m_priority;
+};
+
+inline ResumeOn resumeOn(TaskType type = TaskType::Intensive, int32_t tag = 0,
+                         TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    return ResumeOn(type, tag, priority);
+}
+} // namespace tasks
+} // namespace asynqro
+
+template <typename T, typename FailureT, typename... Args>
+struct std::coroutine_traits<asynqro::Future<T, FailureT>, Args...>
+{
+    using promise_type = asynqro::detail::CoroutinePromise<T, FailureT, asynqro::Future<T, FailureT>>;
+};
+
+template <typename T, typename FailureT, typename... Args>
+struct std::coroutine_traits<asynqro::CancelableFuture<T, FailureT>, Args...>
+{
+    using promise_type = asynqro::detail::CoroutinePromise<T, FailureT, asynqro::CancelableFuture<T, FailureT>>;
+};
+#endif
+
+#endif // ASYNQRO_COROUTINES_H
@@ -29,8 +29,13 @@
 #include "asynqro/impl/cancelablefuture.h"
 #include "asynqro/impl/containers_traverse.h"
 #include "asynqro/impl/failure_handling.h"
+#include "asynqro/impl/intrusiveptr.h"
+#include "asynqro/impl/memorypool.h"
+#include "asynqro/impl/parking.h"
 #include "asynqro/impl/promise.h"
 #include "asynqro/impl/spinlock.h"
+#include "asynqro/impl/tasktypes.h"
+#include "asynqro/impl/uniquefunction.h"
 #include "asynqro/impl/zipfutures.h"
 
 #ifdef ASYNQRO_QT_SUPPORT
@@ -40,16 +45,25 @@
 #    include <QThread>
 #endif
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <condition_variable>
+#include <deque>
 #include <functional>
 #include <iostream>
-#include <list>
+#include <iterator>
 #include <memory>
 #include <mutex>
+#include <new>
+#include <optional>
+#include <thread>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <variant>
+#include <vector>
 
 namespace asynqro {
 namespace detail {
@@ -57,15 +71,111 @@ enum FutureState
 {
     NotCompletedFuture = 0,
     SucceededFuture = 1,
-    FailedFuture = 2
+    FailedFuture = 2,
+    CompletingFuture = 3
 };
+// State word also carries flag that some threads are parked on it and should be woken up on fill
+// and flag that future was waited by waitAll()/waitAny() and its fill should bump WatchedFuturesEpoch
+constexpr int FUTURE_STATE_MASK = 0x3;
+constexpr int FUTURE_HAS_WAITERS_FLAG = 0x4;
+constexpr int FUTURE_WATCHED_FLAG = 0x8;
+
+// waitAll()/waitAny() park on this single word instead of registering callbacks in futures, so waits that
+// return early or time out leave nothing behind. Any watched future fill wakes all of them up to recheck.
+struct WatchedFuturesEpoch
+{
+    std::atomic_int value{0};
+    std::atomic_int parkedWaiters{0};
+};
+ASYNQRO_EXPORT WatchedFuturesEpoch &watchedFuturesEpoch() noexcept;
 
 void ASYNQRO_EXPORT incrementFuturesUsage();
 void ASYNQRO_EXPORT decrementFuturesUsage();
 
+// Per-thread queue of continuations that were deferred because of too deep recursion.
+// Outermost continuation frame runs them in a loop, so stack usage stays bounded without scheduler round-trips.
+struct ContinuationsTrampoline
+{
+    int32_t depth = 0;
+    std::deque<UniqueFunction<void()>> deferred;
+};
+
+ASYNQRO_EXPORT ContinuationsTrampoline &currentContinuationsTrampoline() noexcept;
+ASYNQRO_EXPORT int32_t currentContinuationsDepthLimit() noexcept;
+
+inline void drainDeferredContinuations(ContinuationsTrampoline &trampoline) noexcept
+{
+    while (!trampoline.deferred.empty()) {
+        UniqueFunction<void()> next = std::move(trampoline.deferred.front());
+        trampoline.deferred.pop_front();
+        ++trampoline.depth;
+        try {
+            next();
+        } catch (...) {
+        }
+        --trampoline.depth;
+    }
+}
+
+// Runs f right away unless continuations recursion is already too deep (or deferring is forced and we are
+// inside of another continuation). In this case f is queued and will be run by outermost continuation frame.
+template <typename Func>
+void runTrampolined(Func &&f, bool forceDefer = false) noexcept
+{
+    ContinuationsTrampoline &trampoline = currentContinuationsTrampoline();
+    if (trampoline.depth > 0 && (forceDefer || trampoline.depth >= currentContinuationsDepthLimit())) {
+        try {
+            trampoline.deferred.emplace_back(std::forward<Func>(f));
+            return;
+        } catch (...) {
+            // Running inline if continuation can't be deferred
+        }
+    }
+    ++trampoline.depth;
+    try {
+        f();
+    } catch (...) {
+    }
+    if (--trampoline.depth == 0)
+        drainDeferredContinuations(trampoline);
+}
+
+// Shared state of sequence fan-in. Each input fills its own slot and the last one assembles result.
+template <typename Slot>
+struct SequenceState
+{
+    explicit SequenceState(size_t size) : slots(size), remaining(static_cast<int_fast64_t>(size)) {}
+    std::vector<Slot> slots;
+    std::atomic_int_fast64_t remaining;
+};
+
+// Result of sequenceWithFailures. std::vector results are index-addressed, other containers are associative.
+template <template <typename...> typename ResultContainer, typename IndexType, typename T, typename FailureT>
+struct SequenceWithFailuresResult
+{
+    using type = std::pair<ResultContainer<IndexType, T>, ResultContainer<IndexType, FailureT>>;
+};
+
+template <typename IndexType, typename T, typename FailureT>
+struct SequenceWithFailuresResult<std::vector, IndexType, T, FailureT>
+{
+    using type = std::pair<std::vector<std::optional<T>>, std::vector<std::optional<FailureT>>>;
+};
+
 template <typename T, typename FailureT>
 struct FutureData
 {
+    using ValueStorage = std::variant<std::monostate, T, FailureT>;
+    // Single continuation type for both outcomes, it is called with filled value storage
+    using Continuation = UniqueFunction<void(const ValueStorage &)>;
+    struct ContinuationNode
+    {
+        ContinuationNode *next = nullptr;
+        Continuation f;
+    };
+    // Most futures have one or two continuations, they are stored in FutureData itself without extra allocations
+    static constexpr uint32_t INLINE_CONTINUATIONS_AMOUNT = 2;
+
     FutureData() // NOLINT(modernize-use-equals-default)
     {
 #ifdef ASYNQRO_DEBUG_COUNT_OBJECTS
@@ -76,20 +186,111 @@ struct FutureData
     FutureData(FutureData<T, FailureT> &&) = delete;
     FutureData<T, FailureT> &operator=(const FutureData<T, FailureT> &) = delete;
     FutureData<T, FailureT> &operator=(FutureData<T, FailureT> &&) = delete;
-    ~FutureData() // NOLINT(modernize-use-equals-default)
+    ~FutureData()
     {
+        ContinuationNode *node = continuations.load(std::memory_order_acquire);
+        while (node && node != completedMarker()) {
+            ContinuationNode *next = node->next;
+            releaseNode(node);
+            node = next;
+        }
 #ifdef ASYNQRO_DEBUG_COUNT_OBJECTS
         decrementFuturesUsage();
 #endif
     }
 
+    static void *operator new(size_t size)
+    {
+#ifdef ASYNQRO_DEBUG_COUNT_OBJECTS
+        return allocateFromPoolCounted(size);
+#else
+        return allocateFromPool(size);
+#endif
+    }
+    static void operator delete(void *ptr, size_t size) noexcept { deallocateToPool(ptr, size); }
+    // Pooled memory has only default new alignment, so over-aligned values or failures go to global new
+    static void *operator new(size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); }
+    static void operator delete(void *ptr, size_t, std::align_val_t alignment) noexcept
+    {
+        ::operator delete(ptr, alignment);
+    }
+
+    void ref() noexcept { refCount.fetch_add(1, std::memory_order_relaxed); }
+    void deref() noexcept
+    {
+        if (refCount.fetch_sub(1, std::memory_order_acq_rel) != 1)
+            return;
+        if (releaseHook)
+            releaseHook(this);
+        else
+            delete this;
+    }
+
+    static ContinuationNode *completedMarker() noexcept
+    {
+        return reinterpret_cast<ContinuationNode *>(&completedTag);
+    }
+
+    // Takes one of inline nodes if any is still available, allocates new one otherwise
+    ContinuationNode *acquireNode()
+    {
+        if (usedInlineNodes.load(std::memory_order_relaxed) < INLINE_CONTINUATIONS_AMOUNT) {
+            uint32_t index = usedInlineNodes.fetch_add(1, std::memory_order_relaxed);
+            if (index < INLINE_CONTINUATIONS_AMOUNT)
+                return &inlineNodes[index];
+        }
+        return new ContinuationNode;
+    }
+
+    void releaseNode(ContinuationNode *node) noexcept
+    {
+        if (std::less_equal<>()(inlineNodes, node) && std::less<>()(node, inlineNodes + INLINE_CONTINUATIONS_AMOUNT))
+            node->f = nullptr;
+        else
+            delete node;
+    }
+
+    // Returns false if continuations were already taken by fill and node wasn't added
+    bool pushContinuation(ContinuationNode *node) noexcept
+    {
+        ContinuationNode *head = continuations.load(std::memory_order_acquire);
+        do {
+            if (head == completedMarker())
+                return false;
+            node->next = head;
+        } while (
+            !continuations.compare_exchange_weak(head, node, std::memory_order_acq_rel, std::memory_order_acquire));
+        return true;
+    }
+
+    // Should be called only by thread that moved state out of NotCompletedFuture and only after final state is set.
+    // Returns continuations in order of their registration.
+    ContinuationNode *takeContinuations() noexcept
+    {
+        ContinuationNode *head = continuations.exchange(completedMarker(), std::memory_order_acq_rel);
+        ContinuationNode *reversed = nullptr;
+        while (head) {
+            ContinuationNode *next = head->next;
+            head->next = reversed;
+            reversed = head;
+            head = next;
+        }
+        return reversed;
+    }
+
+    std::atomic_int_fast32_t refCount{0};
     std::atomic_int state{NotCompletedFuture};
-    std::variant<std::monostate, T, FailureT> value;
+    ValueStorage value;
 
-    std::list<std::function<void(const T &)>> successCallbacks;
-    std::list<std::function<void(const FailureT &)>> failureCallbacks;
+    // Intrusive stack of continuations. Replaced with completedMarker() when future is filled.
+    std::atomic<ContinuationNode *> continuations{nullptr};
+    std::atomic_uint32_t usedInlineNodes{0};
+    ContinuationNode inlineNodes[INLINE_CONTINUATIONS_AMOUNT];
+    // Set if this object is embedded into other storage (coroutine frame for example) and shouldn't be just deleted
+    void (*releaseHook)(FutureData<T, FailureT> *) = nullptr;
 
-    SpinLock mainLock;
+private:
+    inline static char completedTag = 0;
 };
 
 } // namespace detail
@@ -97,6 +298,21 @@ struct FutureData
 template <typename T, typename FailureT>
 struct Trampoline;
 
+namespace tasks::detail {
+template <typename T, typename FailureT, typename Job>
+struct TaskFutureData;
+} // namespace tasks::detail
+
+namespace detail {
+template <typename T, typename FailureT, typename Result>
+struct CoroutinePromise;
+template <typename T, typename FailureT, typename OuterPromise>
+struct FutureAwaiter;
+
+template <typename Container>
+bool waitForCompletions(const Container &futures, bool waitForAll, std::chrono::milliseconds timeout) noexcept;
+} // namespace detail
+
 template <typename T, typename FailureT>
 class Future
 {
@@ -104,12 +320,25 @@ class Future
     static_assert(!std::is_same_v<FailureT, void>, "Future<_, void> is not allowed. Use Future<_, bool> instead");
     template <typename T2, typename FailureT2>
     friend class Future;
+    template <typename T2, typename FailureT2>
+    friend class UniquePromise;
     friend class Promise<T, FailureT>;
     friend struct detail::FutureData<T, FailureT>;
     friend struct WithFailure<FailureT>;
     template <typename... U>
     friend class CancelableFuture;
     friend struct Trampoline<T, FailureT>;
+    template <typename T2, typename FailureT2, typename Result>
+    friend struct detail::CoroutinePromise;
+    template <typename T2, typename FailureT2, typename OuterPromise>
+    friend struct detail::FutureAwaiter;
+    template <typename T2, typename FailureT2, typename Job>
+    friend struct tasks::detail::TaskFutureData;
+    template <typename Container>
+    friend bool detail::waitForCompletions(const Container &, bool, std::chrono::milliseconds) noexcept;
+
+    using ValueStorage = typename detail::FutureData<T, FailureT>::ValueStorage;
+    using ContinuationNode = typename detail::FutureData<T, FailureT>::ContinuationNode;
 
 public:
     using Value = T;
@@ -139,18 +368,19 @@ public:
     bool isCompleted() const noexcept
     {
         assert(d);
-        int value = d->state.load(std::memory_order_acquire);
-        return value == detail::FutureState::FailedFuture || value == detail::FutureState::SucceededFuture;
+        return isCompletedState(d->state.load(std::memory_order_acquire));
     }
     bool isFailed() const noexcept
     {
         assert(d);
-        return d->state.load(std::memory_order_acquire) == detail::FutureState::FailedFuture;
+        return (d->state.load(std::memory_order_acquire) & detail::FUTURE_STATE_MASK)
+               == detail::FutureState::FailedFuture;
     }
     bool isSucceeded() const noexcept
     {
         assert(d);
-        return d->state.load(std::memory_order_acquire) == detail::FutureState::SucceededFuture;
+        return (d->state.load(std::memory_order_acquire) & detail::FUTURE_STATE_MASK)
+               == detail::FutureState::SucceededFuture;
     }
 
     bool isValid() const noexcept { return static_cast<bool>(d); }
@@ -161,6 +391,10 @@ public:
     {
         using namespace std::chrono_literals;
         assert(d);
+        if (isCompleted())
+            return true;
+        // Continuation that should fill this future can be deferred by this thread, so we run them all first
+        detail::drainDeferredContinuations(detail::currentContinuationsTrampoline());
         if (isCompleted())
             return true;
         bool waitForever = timeout.count() < 1;
@@ -177,48 +411,25 @@ public:
                 QCoreApplication::processEvents();
             }
 #endif
-        } else if (waitForever) {
-            // Optimized version with no extra memory allocations
-            std::mutex mutex;
-            std::condition_variable waiter;
-            std::unique_lock lock(mutex);
-            bool wasInSameThread = false;
-            std::atomic_bool canExit = false;
-            onComplete([&waiter, &mutex, &wasInSameThread, &canExit, waitingThread = std::this_thread::get_id()]() {
-                if (std::this_thread::get_id() == waitingThread) {
-                    canExit.store(true, std::memory_order_relaxed);
-                    wasInSameThread = true;
-                    return;
+        } else {
+            // Parking on state word itself, no extra memory allocations or spinning are needed
+            auto finalPoint = std::chrono::steady_clock::now() + timeout;
+            int current = d->state.load(std::memory_order_acquire);
+            while (!isCompletedState(current)) {
+                if (!(current & detail::FUTURE_HAS_WAITERS_FLAG)) {
+                    current = d->state.fetch_or(detail::FUTURE_HAS_WAITERS_FLAG, std::memory_order_acq_rel);
+                    if (isCompletedState(current))
+                        break;
+                    current |= detail::FUTURE_HAS_WAITERS_FLAG;
                 }
-                mutex.lock(); // We wait here for waiter start
-                mutex.unlock();
-                waiter.notify_all();
-                canExit.store(true, std::memory_order_relaxed);
-            });
-            if (!wasInSameThread) {
-                waiter.wait(lock);
-                // We need to wait here to make sure we are not operating with any dangling references in other thread
-                while (!canExit.load(std::memory_order_relaxed)) {
+                std::chrono::nanoseconds remaining(0);
+                if (!waitForever) {
+                    remaining = finalPoint - std::chrono::steady_clock::now();
+                    if (remaining.count() <= 0)
+                        break;
                 }
-            }
-        } else {
-            try {
-                auto mutex = std::make_shared<std::mutex>();
-                auto waiter = std::make_shared<std::condition_variable>();
-                std::unique_lock lock(*mutex);
-                auto wasInSameThread = std::make_shared<bool>(false);
-                onComplete([waiter, mutex, wasInSameThread, waitingThread = std::this_thread::get_id()]() {
-                    if (std::this_thread::get_id() == waitingThread) {
-                        *wasInSameThread = true;
-                        return;
-                    }
-                    mutex->lock(); // We wait here for waiter start
-                    mutex->unlock();
-                    waiter->notify_all();
-                });
-                if (!*wasInSameThread)
-                    waiter->wait_for(lock, timeout);
-            } catch (...) {
+                detail::parkWhileEqual(&d->state, current, remaining);
+                current = d->state.load(std::memory_order_acquire);
             }
         }
         return isCompleted();
@@ -265,26 +476,44 @@ public:
     Future<T, FailureT> onSuccess(Func &&f) const noexcept
     {
         assert(d);
-        bool callIt = false;
-        detail::SpinLockHolder lock(&d->mainLock);
-        if (isCompleted()) {
-            callIt = isSucceeded();
-        } else {
-            try {
-                d->successCallbacks.emplace_back(std::forward<Func>(f));
-            } catch (const std::exception &e) {
-                return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>(e));
-            } catch (...) {
-                return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>());
-            }
+        try {
+            addContinuation([f = std::forward<Func>(f)](const ValueStorage &value) mutable {
+                if (value.index() == 1)
+                    f(std::get<1>(value));
+            });
+        } catch (const std::exception &e) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>(e));
+        } catch (...) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>());
         }
-        lock.unlock();
+        return Future<T, FailureT>(d);
+    }
 
-        if (callIt) {
-            try {
-                f(std::get<1>(d->value));
-            } catch (...) {
-            }
+    // The same as onSuccess, but f is run by tasks dispatcher in specified subpool.
+    // If future is filled in a worker that already runs task from this subpool then f is called inline.
+    template <typename Func, typename = std::enable_if_t<std::is_invocable_v<Func, T>>>
+    Future<T, FailureT> onSuccessOn(Func &&f, tasks::TaskType type = tasks::TaskType::Intensive, int32_t tag = 0,
+                                    tasks::TaskPriority priority = tasks::TaskPriority::Regular) const noexcept
+    {
+        assert(d);
+        try {
+            addContinuation([f = std::forward<Func>(f), source = d.get(), type, tag,
+                             priority](const ValueStorage &value) mutable {
+                if (value.index() != 1)
+                    return;
+                if (tasks::detail::isCurrentWorkerInSubPool(type, tag)) {
+                    f(std::get<1>(value));
+                    return;
+                }
+                // Source data is kept alive by task itself, so value doesn't need to be copied
+                tasks::detail::postContinuation(
+                    [f = std::move(f), source = detail::IntrusivePtr(source)]() mutable { f(std::get<1>(source->value)); },
+                    type, tag, priority);
+            });
+        } catch (const std::exception &e) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>(e));
+        } catch (...) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>());
         }
         return Future<T, FailureT>(d);
     }
@@ -293,26 +522,15 @@ public:
     Future<T, FailureT> onFailure(Func &&f) const noexcept
     {
         assert(d);
-        bool callIt = false;
-        detail::SpinLockHolder lock(&d->mainLock);
-        if (isCompleted()) {
-            callIt = isFailed();
-        } else {
-            try {
-                d->failureCallbacks.emplace_back(std::forward<Func>(f));
-            } catch (const std::exception &e) {
-                return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>(e));
-            } catch (...) {
-                return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>());
-            }
-        }
-        lock.unlock();
-
-        if (callIt) {
-            try {
-                f(std::get<2>(d->value));
-            } catch (...) {
-            }
+        try {
+            addContinuation([f = std::forward<Func>(f)](const ValueStorage &value) mutable {
+                if (value.index() == 2)
+                    f(std::get<2>(value));
+            });
+        } catch (const std::exception &e) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>(e));
+        } catch (...) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>());
         }
         return Future<T, FailureT>(d);
     }
@@ -321,8 +539,13 @@ public:
     Future<T, FailureT> onComplete(Func &&f) const noexcept
     {
         assert(d);
-        onSuccess([f](const auto &) noexcept { f(); });
-        onFailure([f = std::forward<Func>(f)](const auto &) noexcept { f(); });
+        try {
+            addContinuation([f = std::forward<Func>(f)](const ValueStorage &) mutable { f(); });
+        } catch (const std::exception &e) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>(e));
+        } catch (...) {
+            return Future<T, FailureT>::failed(detail::exceptionFailure<FailureT>());
+        }
         return Future<T, FailureT>(d);
     }
 
@@ -331,73 +554,72 @@ public:
     filter(Func &&f, const FailureT &rejected = failure::failureFromString<FailureT>("Result wasn't good enough")) const
         noexcept
     {
-        Future<T, FailureT> result = Future<T, FailureT>::create();
-        onSuccess([result, f = std::forward<Func>(f), rejected](const T &v) noexcept {
-            try {
-                if (f(v))
-                    result.fillSuccess(v);
-                else
-                    result.fillFailure(rejected);
-            } catch (const std::exception &e) {
-                result.fillFailure(detail::exceptionFailure<FailureT>(e));
-            } catch (...) {
-                result.fillFailure(detail::exceptionFailure<FailureT>());
-            }
-        });
-        onFailure([result](const FailureT &failure) noexcept { result.fillFailure(failure); });
-        return result;
+        return chain<T, FailureT>(
+            [f = std::forward<Func>(f), rejected](const Future<T, FailureT> &result, const ValueStorage &value) {
+                if (value.index() == 2) {
+                    result.fillFailure(std::get<2>(value));
+                    return;
+                }
+                try {
+                    if (f(std::get<1>(value)))
+                        result.fillSuccess(std::get<1>(value));
+                    else
+                        result.fillFailure(rejected);
+                } catch (const std::exception &e) {
+                    result.fillFailure(detail::exceptionFailure<FailureT>(e));
+                } catch (...) {
+                    result.fillFailure(detail::exceptionFailure<FailureT>());
+                }
+            });
     }
 
     template <typename Func, typename U = std::invoke_result_t<Func, T>>
     Future<U, FailureT> map(Func &&f) const noexcept
     {
-        Future<U, FailureT> result = Future<U, FailureT>::create();
-        onSuccess([result, f = std::forward<Func>(f)](const T &v) noexcept {
-            try {
-                result.fillSuccess(f(v));
-            } catch (const std::exception &e) {
-                result.fillFailure(detail::exceptionFailure<FailureT>(e));
-            } catch (...) {
-                result.fillFailure(detail::exceptionFailure<FailureT>());
-            }
-        });
-        onFailure([result](const FailureT &failure) noexcept { result.fillFailure(failure); });
-        return result;
+        return chain<U, FailureT>(mapper<U>(std::forward<Func>(f)));
+    }
+
+    // The same as map, but f is run by tasks dispatcher in specified subpool.
+    // If future is filled in a worker that already runs task from this subpool then f is called inline.
+    template <typename Func, typename U = std::invoke_result_t<Func, T>>
+    Future<U, FailureT> mapOn(Func &&f, tasks::TaskType type = tasks::TaskType::Intensive, int32_t tag = 0,
+                              tasks::TaskPriority priority = tasks::TaskPriority::Regular) const noexcept
+    {
+        return chainOn<U, FailureT>(type, tag, priority, mapper<U>(std::forward<Func>(f)));
     }
 
     template <typename Func, typename OtherFailure = std::invoke_result_t<Func, FailureT>>
     Future<T, OtherFailure> mapFailure(Func &&f) const noexcept
     {
-        Future<T, OtherFailure> result = Future<T, OtherFailure>::create();
-        onSuccess([result](const T &v) noexcept { result.fillSuccess(v); });
-        onFailure([result, f = std::forward<Func>(f)](const FailureT &failure) noexcept {
-            try {
-                result.fillFailure(f(failure));
-            } catch (const std::exception &e) {
-                result.fillFailure(detail::exceptionFailure<OtherFailure>(e));
-            } catch (...) {
-                result.fillFailure(detail::exceptionFailure<OtherFailure>());
-            }
-        });
-        return result;
+        return chain<T, OtherFailure>(
+            [f = std::forward<Func>(f)](const Future<T, OtherFailure> &result, const ValueStorage &value) {
+                if (value.index() == 1) {
+                    result.fillSuccess(std::get<1>(value));
+                    return;
+                }
+                try {
+                    result.fillFailure(f(std::get<2>(value)));
+                } catch (const std::exception &e) {
+                    result.fillFailure(detail::exceptionFailure<OtherFailure>(e));
+                } catch (...) {
+                    result.fillFailure(detail::exceptionFailure<OtherFailure>());
+                }
+            });
     }
 
     template <typename Func, typename U = decltype(std::declval<std::invoke_result_t<Func, T>>().result())>
     Future<U, FailureT> flatMap(Func &&f) const noexcept
     {
-        Future<U, FailureT> result = Future<U, FailureT>::create();
-        onSuccess([result, f = std::forward<Func>(f)](const T &v) noexcept {
-            try {
-                f(v).onSuccess([result](const U &v) noexcept { result.fillSuccess(v); })
-                    .onFailure([result](const FailureT &failure) noexcept { result.fillFailure(failure); });
-            } catch (const std::exception &e) {
-                result.fillFailure(detail::exceptionFailure<FailureT>(e));
-            } catch (...) {
-                result.fillFailure(detail::exceptionFailure<FailureT>());
-            }
-        });
-        onFailure([result](const FailureT &failure) noexcept { result.fillFailure(failure); });
-        return result;
+        return chain<U, FailureT>(flatMapper<U>(std::forward<Func>(f)));
+    }
+
+    // The same as flatMap, but f is run by tasks dispatcher in specified subpool.
+    // If future is filled in a worker that already runs task from this subpool then f is called inline.
+    template <typename Func, typename U = decltype(std::declval<std::invoke_result_t<Func, T>>().result())>
+    Future<U, FailureT> flatMapOn(Func &&f, tasks::TaskType type = tasks::TaskType::Intensive, int32_t tag = 0,
+                                  tasks::TaskPriority priority = tasks::TaskPriority::Regular) const noexcept
+    {
+        return chainOn<U, FailureT>(type, tag, priority, flatMapper<U>(std::forward<Func>(f)));
     }
 
     template <typename Func>
@@ -456,18 +678,20 @@ public:
     template <typename Func, typename = std::enable_if_t<std::is_invocable_v<Func, FailureT>>>
     Future<T, FailureT> recover(Func &&f) const noexcept
     {
-        Future<T, FailureT> result = Future<T, FailureT>::create();
-        onSuccess([result](const T &v) noexcept { result.fillSuccess(v); });
-        onFailure([result, f = std::forward<Func>(f)](const FailureT &failure) noexcept {
-            try {
-                result.fillSuccess(f(failure));
-            } catch (const std::exception &e) {
-                result.fillFailure(detail::exceptionFailure<FailureT>(e));
-            } catch (...) {
-                result.fillFailure(detail::exceptionFailure<FailureT>());
-            }
-        });
-        return result;
+        return chain<T, FailureT>(
+            [f = std::forward<Func>(f)](const Future<T, FailureT> &result, const ValueStorage &value) {
+                if (value.index() == 1) {
+                    result.fillSuccess(std::get<1>(value));
+                    return;
+                }
+                try {
+                    result.fillSuccess(f(std::get<2>(value)));
+                } catch (const std::exception &e) {
+                    result.fillFailure(detail::exceptionFailure<FailureT>(e));
+                } catch (...) {
+                    result.fillFailure(detail::exceptionFailure<FailureT>());
+                }
+            });
     }
 
     template <typename Func,
@@ -475,20 +699,20 @@ public:
               typename = decltype(std::declval<std::invoke_result_t<Func, FailureT>>().result())>
     Future<T, OtherFailure> recoverWith(Func &&f) const noexcept
     {
-        Future<T, OtherFailure> result = Future<T, OtherFailure>::create();
-        onSuccess([result](const T &v) noexcept { result.fillSuccess(v); });
-        onFailure([result, f = std::forward<Func>(f)](const FailureT &failure) noexcept {
-            try {
-                f(failure)
-                    .onSuccess([result](const T &v) noexcept { result.fillSuccess(v); })
-                    .onFailure([result](const OtherFailure &failure) noexcept { result.fillFailure(failure); });
-            } catch (const std::exception &e) {
-                result.fillFailure(detail::exceptionFailure<OtherFailure>(e));
-            } catch (...) {
-                result.fillFailure(detail::exceptionFailure<OtherFailure>());
-            }
-        });
-        return result;
+        return chain<T, OtherFailure>(
+            [f = std::forward<Func>(f)](const Future<T, OtherFailure> &result, const ValueStorage &value) {
+                if (value.index() == 1) {
+                    result.fillSuccess(std::get<1>(value));
+                    return;
+                }
+                try {
+                    result.fillFrom(Future<T, OtherFailure>(f(std::get<2>(value))));
+                } catch (const std::exception &e) {
+                    result.fillFailure(detail::exceptionFailure<OtherFailure>(e));
+                } catch (...) {
+                    result.fillFailure(detail::exceptionFailure<OtherFailure>());
+                }
+            });
     }
 
     template <typename Dummy = void, typename = std::enable_if_t<std::is_copy_constructible_v<T>, Dummy>>
@@ -503,28 +727,8 @@ public:
               typename NewFailure = detail::TypesSum_T<FailureT, InnerZipFailure>>
     Future<Result, NewFailure> zip(Head head, Tail... tail) const noexcept
     {
-        if constexpr (std::is_same_v<FailureT, NewFailure>) {
-            return flatMap([head, tail...](const T &v) noexcept -> Future<Result, FailureT> {
-                return head.zip(tail...).map([v](const auto &argsResult) noexcept -> Result {
-                    return std::tuple_cat(detail::AsTuple<T>::make(v), argsResult);
-                });
-            });
-        } else { // NOLINT(readability-else-after-return,readability-misleading-indentation)
-            return mapFailure([](const FailureT &failure) {
-                       return std::visit([](auto &&x) noexcept -> NewFailure { return x; },
-                                         detail::AsVariant<FailureT>::make(failure));
-                   })
-                .flatMap([head, tail...](const T &v) noexcept -> Future<Result, NewFailure> {
-                    return head.zip(tail...)
-                        .mapFailure([](const InnerZipFailure &failure) {
-                            return std::visit([](auto &&x) noexcept -> NewFailure { return x; },
-                                              detail::AsVariant<InnerZipFailure>::make(failure));
-                        })
-                        .map([v](const auto &argsResult) noexcept -> Result {
-                            return std::tuple_cat(detail::AsTuple<T>::make(v), argsResult);
-                        });
-                });
-        }
+        return zipAll<Result, NewFailure>(*this, Future<typename Head::Value, typename Head::Failure>(head),
+                                          Future<typename Tail::Value, typename Tail::Failure>(tail)...);
     }
 
     template <typename T2, typename Result = detail::TypesProduct_T<T, std::decay_t<T2>>>
@@ -556,41 +760,69 @@ public:
         return result;
     }
 
-    // This overload copies container to make sure that it will be reachable in future
-    template <template <typename...> typename F, template <typename...> typename Container, typename... Fs>
-    static Future<Container<T>, FailureT> sequence(const Container<F<T, FailureT>, Fs...> &container) noexcept
-    {
-        Container<F<T, FailureT>> copy(container);
-        return sequence(std::move(copy));
-    }
-
     template <template <typename...> typename F, template <typename...> typename Container, typename... Fs,
               typename FullF = F<T, FailureT>, typename Dummy = void,
               typename = std::enable_if_t<std::is_copy_constructible_v<T>, Dummy>,
               typename = std::enable_if_t<
                   std::is_same_v<FullF, Future<T, FailureT>> || std::is_same_v<FullF, CancelableFuture<T, FailureT>>>>
-    static Future<Container<T>, FailureT> sequence(Container<F<T, FailureT>, Fs...> &&container) noexcept
+    static Future<Container<T>, FailureT> sequence(const Container<F<T, FailureT>, Fs...> &container) noexcept
     {
+        using Result = Container<T>;
         if (container.empty())
-            return Future<Container<T>, FailureT>::successful();
-        Future<Container<T>, FailureT> future = Future<Container<T>, FailureT>::create();
-        Container<T> result;
-        traverse::detail::containers::reserve(result, container.size());
-        iterateSequence(std::move(container), container.cbegin(), std::move(result), future);
+            return Future<Result, FailureT>::successful();
+        Future<Result, FailureT> future = Future<Result, FailureT>::create();
+        try {
+            auto state = std::make_shared<detail::SequenceState<std::optional<T>>>(container.size());
+            size_t index = 0;
+            for (const auto &input : container) {
+                Future<T, FailureT>(input).addContinuation([state, future, index](const ValueStorage &value) noexcept {
+                    if (value.index() == 2) {
+                        future.fillFailure(std::get<2>(value));
+                        return;
+                    }
+                    if (future.isCompleted())
+                        return;
+                    try {
+                        state->slots[index].emplace(std::get<1>(value));
+                        if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                            return;
+                        Result result;
+                        traverse::detail::containers::reserve(result, state->slots.size());
+                        for (auto &slot : state->slots)
+                            traverse::detail::containers::add(result, std::move(*slot));
+                        future.fillSuccess(std::move(result));
+                    } catch (const std::exception &e) {
+                        future.fillFailure(detail::exceptionFailure<FailureT>(e));
+                    } catch (...) {
+                        future.fillFailure(detail::exceptionFailure<FailureT>());
+                    }
+                });
+                ++index;
+            }
+        } catch (const std::exception &e) {
+            future.fillFailure(detail::exceptionFailure<FailureT>(e));
+        } catch (...) {
+            future.fillFailure(detail::exceptionFailure<FailureT>());
+        }
         return future;
     }
 
-    // This overload copies container to make sure that it will be reachable in future
-    template <template <typename...> typename ResultContainer = std::unordered_map, typename Container>
-    static auto sequenceWithFailures(const Container &container) noexcept
+    template <template <typename...> typename F, template <typename...> typename Container, typename... Fs,
+              typename FullF = F<T, FailureT>, typename Dummy = void,
+              typename = std::enable_if_t<std::is_copy_constructible_v<T>, Dummy>,
+              typename = std::enable_if_t<
+                  std::is_same_v<FullF, Future<T, FailureT>> || std::is_same_v<FullF, CancelableFuture<T, FailureT>>>>
+    static Future<Container<T>, FailureT> sequence(Container<F<T, FailureT>, Fs...> &&container) noexcept
     {
-        Container copy(container);
-        return sequenceWithFailures<ResultContainer>(std::move(copy));
+        // Inputs are not needed after continuations are registered, so there is nothing to keep
+        return sequence(static_cast<const Container<F<T, FailureT>, Fs...> &>(container));
     }
 
     template <template <typename...> typename ResultContainer = std::unordered_map, typename Container,
-              typename F = typename Container::value_type, typename IndexType = typename Container::size_type,
-              typename ResultType = std::pair<ResultContainer<IndexType, T>, ResultContainer<IndexType, FailureT>>,
+              typename F = typename std::decay_t<Container>::value_type,
+              typename IndexType = typename std::decay_t<Container>::size_type,
+              typename ResultType =
+                  typename detail::SequenceWithFailuresResult<ResultContainer, IndexType, T, FailureT>::type,
               typename Dummy = void, typename = std::enable_if_t<std::is_copy_constructible_v<T>, Dummy>,
               typename = std::enable_if_t<std::is_same_v<F, Future<T, FailureT>> || std::is_same_v<F, CancelableFuture<T, FailureT>>>>
     static Future<ResultType, FailureT> sequenceWithFailures(Container &&container) noexcept
@@ -598,8 +830,29 @@ public:
         if (container.empty())
             return Future<ResultType, FailureT>::successful();
         auto future = Future<ResultType, FailureT>::create();
-        ResultType result;
-        iterateSequenceWithFailures(std::forward<Container>(container), container.cbegin(), 0, std::move(result), future);
+        try {
+            auto state = std::make_shared<detail::SequenceState<ValueStorage>>(container.size());
+            size_t index = 0;
+            for (const auto &input : container) {
+                Future<T, FailureT>(input).addContinuation([state, future, index](const ValueStorage &value) noexcept {
+                    try {
+                        state->slots[index] = value;
+                        if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                            return;
+                        future.fillSuccess(assembleSequenceWithFailures<ResultType, IndexType>(state->slots));
+                    } catch (const std::exception &e) {
+                        future.fillFailure(detail::exceptionFailure<FailureT>(e));
+                    } catch (...) {
+                        future.fillFailure(detail::exceptionFailure<FailureT>());
+                    }
+                });
+                ++index;
+            }
+        } catch (const std::exception &e) {
+            future.fillFailure(detail::exceptionFailure<FailureT>(e));
+        } catch (...) {
+            future.fillFailure(detail::exceptionFailure<FailureT>());
+        }
         return future;
     }
 
@@ -677,11 +930,11 @@ public:
 #endif
 
 private:
-    explicit Future(const std::shared_ptr<detail::FutureData<T, FailureT>> &otherD) { d = otherD; }
+    explicit Future(const detail::IntrusivePtr<detail::FutureData<T, FailureT>> &otherD) { d = otherD; }
     inline static Future<T, FailureT> create()
     {
         Future<T, FailureT> result;
-        result.d = std::make_shared<detail::FutureData<T, FailureT>>();
+        result.d = detail::IntrusivePtr(new detail::FutureData<T, FailureT>());
         return result;
     }
 
@@ -701,26 +954,14 @@ private:
             return;
         }
 
-        detail::SpinLockHolder lock(&d->mainLock);
-        if (isCompleted())
+        if (!startCompletion())
             return;
         try {
             d->value.template emplace<1>(std::forward<T>(result));
         } catch (...) {
             // Should never happen
         }
-        d->state.store(detail::FutureState::SucceededFuture, std::memory_order_release);
-        const auto callbacks = std::move(d->successCallbacks);
-        d->successCallbacks = std::list<std::function<void(const T &)>>();
-        d->failureCallbacks.clear();
-        lock.unlock();
-
-        for (const auto &f : callbacks) {
-            try {
-                f(std::get<1>(d->value));
-            } catch (...) {
-            }
-        }
+        finishCompletion(detail::FutureState::SucceededFuture);
     }
 
     void fillFailure(const FailureT &reason) const noexcept
@@ -732,107 +973,384 @@ private:
     void fillFailure(FailureT &&reason) const noexcept
     {
         assert(d);
-
-        detail::SpinLockHolder lock(&d->mainLock);
-        if (isCompleted())
+        if (!startCompletion())
             return;
         try {
             d->value.template emplace<2>(std::forward<FailureT>(reason));
         } catch (...) {
             // Should never happen
         }
-        d->state.store(detail::FutureState::FailedFuture, std::memory_order_release);
-        const auto callbacks = std::move(d->failureCallbacks);
-        d->failureCallbacks = std::list<std::function<void(const FailureT &)>>();
-        d->successCallbacks.clear();
-        lock.unlock();
+        finishCompletion(detail::FutureState::FailedFuture);
+    }
+
+    // Only one filler can move future out of NotCompletedFuture state, all others are ignored
+    bool startCompletion() const noexcept
+    {
+        int expected = d->state.load(std::memory_order_relaxed);
+        while ((expected & detail::FUTURE_STATE_MASK) == detail::FutureState::NotCompletedFuture) {
+            int desired = (expected & ~detail::FUTURE_STATE_MASK) | detail::FutureState::CompletingFuture;
+            if (d->state.compare_exchange_weak(expected, desired, std::memory_order_acq_rel, std::memory_order_relaxed))
+                return true;
+        }
+        return false;
+    }
+
+    void finishCompletion(detail::FutureState finalState) const noexcept
+    {
+        int previous = d->state.exchange(finalState, std::memory_order_acq_rel);
+        if (previous & detail::FUTURE_HAS_WAITERS_FLAG)
+            detail::unparkAll(&d->state);
+        if (previous & detail::FUTURE_WATCHED_FLAG) {
+            detail::WatchedFuturesEpoch &epoch = detail::watchedFuturesEpoch();
+            epoch.value.fetch_add(1, std::memory_order_seq_cst);
+            if (epoch.parkedWaiters.load(std::memory_order_seq_cst) > 0)
+                detail::unparkAll(&epoch.value);
+        }
+        ContinuationNode *node = d->takeContinuations();
+        if (!node)
+            return;
+        detail::runTrampolined([data = d, node]() noexcept {
+            ContinuationNode *current = node;
+            while (current) {
+                ContinuationNode *next = current->next;
+                try {
+                    current->f(data->value);
+                } catch (...) {
+                }
+                data->releaseNode(current);
+                current = next;
+            }
+        });
+    }
+
+    // Returns true if future is already completed, otherwise its fill will bump WatchedFuturesEpoch
+    bool watchCompletion() const noexcept
+    {
+        int current = d->state.load(std::memory_order_acquire);
+        if (!(current & detail::FUTURE_WATCHED_FLAG))
+            current = d->state.fetch_or(detail::FUTURE_WATCHED_FLAG, std::memory_order_acq_rel);
+        return isCompletedState(current);
+    }
+
+    static bool isCompletedState(int state) noexcept
+    {
+        state &= detail::FUTURE_STATE_MASK;
+        return state == detail::FutureState::FailedFuture || state == detail::FutureState::SucceededFuture;
+    }
 
-        for (const auto &f : callbacks) {
+    // Calls f immediately if future is already completed, otherwise stores it to be called on fill
+    template <typename Func>
+    void addContinuation(Func &&f) const
+    {
+        if (!isCompleted()) {
+            ContinuationNode *node = d->acquireNode();
             try {
-                f(std::get<2>(d->value));
+                node->f = std::forward<Func>(f);
             } catch (...) {
+                d->releaseNode(node);
+                throw;
             }
+            if (d->pushContinuation(node))
+                return;
+            // Future was completed while we were preparing continuation
+            detail::runTrampolined([data = d, node]() noexcept {
+                try {
+                    node->f(data->value);
+                } catch (...) {
+                }
+                data->releaseNode(node);
+            });
+            return;
         }
+        detail::runTrampolined([data = d, f = std::forward<Func>(f)]() mutable { f(data->value); });
     }
 
-    auto zip() const noexcept
+    // Creates new future and adds continuation that should fill it
+    template <typename U, typename OtherFailure, typename Func>
+    Future<U, OtherFailure> chain(Func &&f) const noexcept
     {
-        return map([](const T &v) noexcept { return detail::AsTuple<T>::make(v); });
+        assert(d);
+        Future<U, OtherFailure> result = Future<U, OtherFailure>::create();
+        try {
+            addContinuation([result, f = std::forward<Func>(f)](const ValueStorage &value) mutable noexcept {
+                f(result, value);
+            });
+        } catch (const std::exception &e) {
+            return Future<U, OtherFailure>::failed(detail::exceptionFailure<OtherFailure>(e));
+        } catch (...) {
+            return Future<U, OtherFailure>::failed(detail::exceptionFailure<OtherFailure>());
+        }
+        return result;
     }
 
-    template <typename It, template <typename...> typename F, typename... Ts, typename... Fs,
-              template <typename...> typename Container>
-    static void iterateSequence(Container<F<T, FailureT>, Fs...> &&initial, It current, Container<T, Ts...> &&result,
-                                const Future<Container<T, Ts...>, FailureT> &future) noexcept
+    // The same as chain, but f is posted to tasks dispatcher unless we are already in specified subpool
+    template <typename U, typename OtherFailure, typename Func>
+    Future<U, OtherFailure> chainOn(tasks::TaskType type, int32_t tag, tasks::TaskPriority priority, Func &&f) const
+        noexcept
     {
-        while (current != initial.cend()) {
-            auto f = (*current);
-            if (!f.isCompleted())
-                break;
-            if (f.isFailed()) {
-                future.fillFailure(f.failureReason());
+        return chain<U, OtherFailure>([f = std::forward<Func>(f), source = d.get(), type, tag, priority](
+                                          const Future<U, OtherFailure> &result, const ValueStorage &value) mutable {
+            if (tasks::detail::isCurrentWorkerInSubPool(type, tag)) {
+                f(result, value);
                 return;
             }
-            traverse::detail::containers::add(result, f.result());
-            ++current;
-        }
-        if (current == initial.cend()) {
-            future.fillSuccess(std::move(result));
-            return;
-        }
-        auto currentFuture = *current;
-        currentFuture
-            .onSuccess([initial = std::move(initial), current, result = std::move(result),
-                        future](const T &) mutable noexcept {
-                Future<T, FailureT>::iterateSequence(std::move(initial), current, std::move(result), future);
-            })
-            .onFailure([future](const FailureT &reason) noexcept { future.fillFailure(reason); });
-    }
-
-    template <typename It, template <typename...> typename F, typename... Fs, template <typename...> typename ResultType,
-              typename... ResultArgs, template <typename...> typename Container>
-    static void iterateSequenceWithFailures(Container<F<T, FailureT>, Fs...> &&initial, It current,
-                                            typename Container<F<T, FailureT>>::size_type index,
-                                            ResultType<ResultArgs...> &&result,
-                                            const Future<ResultType<ResultArgs...>, FailureT> &future) noexcept
+            try {
+                // Source data is kept alive by task itself, so value doesn't need to be copied
+                tasks::detail::postContinuation(
+                    [f = std::move(f), result, source = detail::IntrusivePtr(source)]() mutable noexcept {
+                        f(result, source->value);
+                    },
+                    type, tag, priority);
+            } catch (const std::exception &e) {
+                result.fillFailure(detail::exceptionFailure<OtherFailure>(e));
+            } catch (...) {
+                result.fillFailure(detail::exceptionFailure<OtherFailure>());
+            }
+        });
+    }
+
+    template <typename U, typename Func>
+    static auto mapper(Func &&f)
     {
-        try {
-            while (current != initial.cend()) {
-                auto f = (*current);
-                if (!f.isCompleted())
-                    break;
-                if (f.isSucceeded())
-                    traverse::detail::containers::add(result.first, std::make_pair(index, f.result()));
-                else
-                    traverse::detail::containers::add(result.second, std::make_pair(index, f.failureReason()));
-                ++index;
-                ++current;
+        return [f = std::forward<Func>(f)](const Future<U, FailureT> &result, const ValueStorage &value) {
+            if (value.index() == 2) {
+                result.fillFailure(std::get<2>(value));
+                return;
+            }
+            try {
+                result.fillSuccess(f(std::get<1>(value)));
+            } catch (const std::exception &e) {
+                result.fillFailure(detail::exceptionFailure<FailureT>(e));
+            } catch (...) {
+                result.fillFailure(detail::exceptionFailure<FailureT>());
+            }
+        };
+    }
+
+    template <typename U, typename Func>
+    static auto flatMapper(Func &&f)
+    {
+        return [f = std::forward<Func>(f)](const Future<U, FailureT> &result, const ValueStorage &value) {
+            if (value.index() == 2) {
+                result.fillFailure(std::get<2>(value));
+                return;
+            }
+            try {
+                result.fillFrom(Future<U, FailureT>(f(std::get<1>(value))));
+            } catch (const std::exception &e) {
+                result.fillFailure(detail::exceptionFailure<FailureT>(e));
+            } catch (...) {
+                result.fillFailure(detail::exceptionFailure<FailureT>());
             }
+        };
+    }
+
+    // Fills this future with result of other one when it is completed
+    void fillFrom(const Future<T, FailureT> &other) const
+    {
+        other.addContinuation([result = *this](const ValueStorage &value) noexcept {
+            if (value.index() == 1)
+                result.fillSuccess(std::get<1>(value));
+            else
+                result.fillFailure(std::get<2>(value));
+        });
+    }
+
+    auto zip() const noexcept
+    {
+        return map([](const T &v) noexcept { return detail::AsTuple<T>::make(v); });
+    }
+
+    // All inputs write their values to slots of single shared state, the last one to arrive fills result
+    template <typename Result, typename NewFailure, typename... Inputs>
+    static Future<Result, NewFailure> zipAll(const Inputs &... inputs) noexcept
+    {
+        struct State
+        {
+            std::tuple<std::optional<detail::AsTuple_T<typename Inputs::Value>>...> slots;
+            std::atomic_int remaining{sizeof...(Inputs)};
+        };
+        Future<Result, NewFailure> result = Future<Result, NewFailure>::create();
+        try {
+            auto state = std::make_shared<State>();
+            zipInputs(result, state, std::index_sequence_for<Inputs...>(), inputs...);
         } catch (const std::exception &e) {
-            future.fillFailure(detail::exceptionFailure<Failure>(e));
-            return;
+            result.fillFailure(detail::exceptionFailure<NewFailure>(e));
         } catch (...) {
-            future.fillFailure(detail::exceptionFailure<Failure>());
-            return;
+            result.fillFailure(detail::exceptionFailure<NewFailure>());
         }
+        return result;
+    }
 
-        if (current == initial.cend()) {
-            future.fillSuccess(std::move(result));
-            return;
+    template <typename Result, typename NewFailure, typename State, size_t... Indices, typename... Inputs>
+    static void zipInputs(const Future<Result, NewFailure> &result, const std::shared_ptr<State> &state,
+                          std::index_sequence<Indices...>, const Inputs &... inputs)
+    {
+        (zipInput<Indices>(result, state, inputs), ...);
+    }
+
+    template <size_t Index, typename Result, typename NewFailure, typename State, typename Input>
+    static void zipInput(const Future<Result, NewFailure> &result, const std::shared_ptr<State> &state,
+                         const Input &input)
+    {
+        using InputValue = typename Input::Value;
+        using InputFailure = typename Input::Failure;
+        input.addContinuation([result, state](const typename Input::ValueStorage &value) noexcept {
+            if (value.index() == 2) {
+                if constexpr (std::is_same_v<InputFailure, NewFailure>) {
+                    result.fillFailure(std::get<2>(value));
+                } else { // NOLINT(readability-misleading-indentation)
+                    result.fillFailure(std::visit([](const auto &x) noexcept -> NewFailure { return x; },
+                                                  detail::AsVariant<InputFailure>::make(std::get<2>(value))));
+                }
+                return;
+            }
+            if (result.isCompleted())
+                return;
+            try {
+                std::get<Index>(state->slots).emplace(detail::AsTuple<InputValue>::make(std::get<1>(value)));
+                if (state->remaining.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    return;
+                result.fillSuccess(
+                    std::apply([](auto &... slots) { return std::tuple_cat(std::move(*slots)...); }, state->slots));
+            } catch (const std::exception &e) {
+                result.fillFailure(detail::exceptionFailure<NewFailure>(e));
+            } catch (...) {
+                result.fillFailure(detail::exceptionFailure<NewFailure>());
+            }
+        });
+    }
+
+    template <typename ResultType, typename IndexType>
+    static ResultType assembleSequenceWithFailures(std::vector<ValueStorage> &slots)
+    {
+        ResultType result;
+        if constexpr (detail::IsSpecialization_V<typename ResultType::first_type, std::vector>) {
+            result.first.resize(slots.size());
+            result.second.resize(slots.size());
+            for (size_t i = 0; i < slots.size(); ++i) {
+                if (slots[i].index() == 1)
+                    result.first[i].emplace(std::get<1>(std::move(slots[i])));
+                else
+                    result.second[i].emplace(std::get<2>(std::move(slots[i])));
+            }
+        } else {
+            for (size_t i = 0; i < slots.size(); ++i) {
+                auto index = static_cast<IndexType>(i);
+                if (slots[i].index() == 1)
+                    traverse::detail::containers::add(result.first,
+                                                      std::make_pair(index, std::get<1>(std::move(slots[i]))));
+                else
+                    traverse::detail::containers::add(result.second,
+                                                      std::make_pair(index, std::get<2>(std::move(slots[i]))));
+            }
         }
-        auto currentFuture = *current;
-        currentFuture.andThenValue(true).recoverValue(true).onSuccess(
-            [initial = std::move(initial), current, result = std::move(result), index, future](bool) mutable noexcept {
-                Future<T, FailureT>::iterateSequenceWithFailures(std::move(initial), current, index, std::move(result),
-                                                                 future);
-            });
+        return result;
     }
 
-    std::shared_ptr<detail::FutureData<T, FailureT>> d;
+    detail::IntrusivePtr<detail::FutureData<T, FailureT>> d;
 };
 
 int_fast64_t ASYNQRO_EXPORT instantFuturesUsage();
 
+// Continuations nested deeper than this limit in the same thread are deferred and run later by outermost one
+void ASYNQRO_EXPORT setContinuationsDepthLimit(int32_t limit);
+int32_t ASYNQRO_EXPORT continuationsDepthLimit();
+
+namespace detail {
+template <typename Container>
+bool waitForCompletions(const Container &futures, bool waitForAll, std::chrono::milliseconds timeout) noexcept
+{
+    auto countCompleted = [&futures]() {
+        int result = 0;
+        for (const auto &f : futures)
+            result += f.isCompleted() ? 1 : 0;
+        return result;
+    };
+    const auto total = static_cast<int>(std::distance(futures.cbegin(), futures.cend()));
+    const int target = waitForAll ? total : std::min(total, 1);
+    if (countCompleted() >= target)
+        return true;
+    // Continuations that should fill these futures can be deferred by this thread, so we run them all first
+    drainDeferredContinuations(currentContinuationsTrampoline());
+    if (countCompleted() >= target)
+        return true;
+
+    bool waitForever = timeout.count() < 1;
+    auto finalPoint = std::chrono::steady_clock::now() + timeout;
+    bool maintainEvents = false;
+#ifdef ASYNQRO_QT_SUPPORT
+    maintainEvents = qApp && QThread::currentThread() == qApp->thread();
+#endif
+    if (maintainEvents) {
+#ifdef ASYNQRO_QT_SUPPORT
+        while (waitForever || (std::chrono::steady_clock::now() <= finalPoint)) {
+            if (countCompleted() >= target)
+                return true;
+            QCoreApplication::processEvents();
+        }
+#endif
+        return countCompleted() >= target;
+    }
+
+    using FutureType = std::decay_t<decltype(*futures.cbegin())>;
+    using PlainFuture = Future<typename FutureType::Value, typename FutureType::Failure>;
+    WatchedFuturesEpoch &epoch = watchedFuturesEpoch();
+    // Epoch is read before futures are rechecked, so fill of any of them after that check changes it
+    epoch.parkedWaiters.fetch_add(1, std::memory_order_seq_cst);
+    bool result = false;
+    while (true) {
+        int current = epoch.value.load(std::memory_order_seq_cst);
+        int completed = 0;
+        for (const auto &f : futures) {
+            if constexpr (std::is_same_v<FutureType, PlainFuture>)
+                completed += f.watchCompletion() ? 1 : 0;
+            else
+                completed += PlainFuture(f).watchCompletion() ? 1 : 0;
+        }
+        if (completed >= target) {
+            result = true;
+            break;
+        }
+        std::chrono::nanoseconds left(0);
+        if (!waitForever) {
+            left = finalPoint - std::chrono::steady_clock::now();
+            if (left.count() <= 0)
+                break;
+        }
+        parkWhileEqual(&epoch.value, current, left);
+    }
+    epoch.parkedWaiters.fetch_sub(1, std::memory_order_relaxed);
+    return result;
+}
+} // namespace detail
+
+// Blocks until all futures in container are completed. Returns false if timeout is reached first.
+template <typename Container>
+bool waitAll(const Container &futures, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) noexcept
+{
+    return detail::waitForCompletions(futures, true, timeout);
+}
+
+template <typename Container>
+bool waitAll(const Container &futures, int64_t timeout) noexcept
+{
+    return waitAll(futures, std::chrono::milliseconds(timeout));
+}
+
+// Blocks until at least one of futures in container is completed. Returns false if timeout is reached first.
+template <typename Container>
+bool waitAny(const Container &futures, std::chrono::milliseconds timeout = std::chrono::milliseconds(0)) noexcept
+{
+    return detail::waitForCompletions(futures, false, timeout);
+}
+
+template <typename Container>
+bool waitAny(const Container &futures, int64_t timeout) noexcept
+{
+    return waitAny(futures, std::chrono::milliseconds(timeout));
+}
+
 template <typename LeftT, typename LeftFailure, typename RightT, typename RightFailure>
 auto operator+(const Future<LeftT, LeftFailure> &left, const Future<RightT, RightFailure> &right)
 {
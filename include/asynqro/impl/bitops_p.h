@@ -0,0 +1,59 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_BITOPS_P_H
+#define ASYNQRO_BITOPS_P_H
+
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#    include <intrin.h>
+#endif
+
+namespace asynqro::detail {
+// Both functions are undefined for zero value, callers should check it before
+inline int32_t countTrailingZeros(uint64_t value) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long result = 0;
+    _BitScanForward64(&result, value);
+    return static_cast<int32_t>(result);
+#else
+    return __builtin_ctzll(value);
+#endif
+}
+
+inline int32_t countLeadingZeros(uint64_t value) noexcept
+{
+#if defined(_MSC_VER)
+    unsigned long result = 0;
+    _BitScanReverse64(&result, value);
+    return 63 - static_cast<int32_t>(result);
+#else
+    return __builtin_clzll(value);
+#endif
+}
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_BITOPS_P_H
@@ -74,7 +74,7 @@ public:
     using Value = T;
     using Failure = FailureType;
     CancelableFuture() = default;
-    explicit CancelableFuture(const Promise<T, FailureType> &promise) { m_promise = promise; }
+    explicit CancelableFuture(const Promise<T, FailureType> &promise) : m_promise(promise) {}
     CancelableFuture(CancelableFuture<T, FailureType> &&) noexcept = default;
     CancelableFuture(const CancelableFuture<T, FailureType> &) noexcept = default;
     CancelableFuture<T, FailureType> &operator=(CancelableFuture<T, FailureType> &&) noexcept = default;
@@ -109,6 +109,12 @@ public:
         return future().onSuccess(std::forward<Func>(f));
     }
 
+    template <typename Func, typename... DispatchArgs>
+    auto onSuccessOn(Func &&f, DispatchArgs &&... dispatchArgs) const noexcept
+    {
+        return future().onSuccessOn(std::forward<Func>(f), std::forward<DispatchArgs>(dispatchArgs)...);
+    }
+
     template <typename Func>
     auto onFailure(Func &&f) const noexcept
     {
@@ -135,6 +141,12 @@ public:
         return future().map(std::forward<Func>(f));
     }
 
+    template <typename Func, typename... DispatchArgs>
+    auto mapOn(Func &&f, DispatchArgs &&... dispatchArgs) const noexcept
+    {
+        return future().mapOn(std::forward<Func>(f), std::forward<DispatchArgs>(dispatchArgs)...);
+    }
+
     template <typename Func>
     auto mapFailure(Func &&f) const noexcept
     {
@@ -147,6 +159,12 @@ public:
         return future().flatMap(std::forward<Func>(f));
     }
 
+    template <typename Func, typename... DispatchArgs>
+    auto flatMapOn(Func &&f, DispatchArgs &&... dispatchArgs) const noexcept
+    {
+        return future().flatMapOn(std::forward<Func>(f), std::forward<DispatchArgs>(dispatchArgs)...);
+    }
+
     template <typename Func>
     auto andThen(Func &&f) const noexcept
     {
@@ -0,0 +1,145 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_DYNAMICBITSET_P_H
+#define ASYNQRO_DYNAMICBITSET_P_H
+
+#include "asynqro/impl/bitops_p.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+namespace asynqro::detail {
+// Growable bitset with word-level scans.
+// Bits outside of size() are treated as unset, so setting them grows bitset.
+class DynamicBitset
+{
+public:
+    static constexpr int32_t WORD_SIZE = 64;
+
+    int32_t size() const noexcept { return static_cast<int32_t>(m_words.size()) * WORD_SIZE; }
+    bool any() const noexcept { return m_count > 0; }
+    bool none() const noexcept { return !m_count; }
+    int32_t count() const noexcept { return m_count; }
+
+    bool test(int32_t index) const noexcept
+    {
+        if (index < 0 || index >= size())
+            return false;
+        return m_words[wordIndex(index)] & bitMask(index);
+    }
+
+    // Grows bitset to keep at least amount bits, new bits are unset
+    void reserve(int32_t amount)
+    {
+        if (amount > size())
+            m_words.resize(wordIndex(amount - 1) + 1, 0);
+    }
+
+    // Can throw only if bitset needs to grow
+    void set(int32_t index, bool value = true)
+    {
+        if (index >= size()) {
+            if (!value)
+                return;
+            m_words.resize(wordIndex(index) + 1, 0);
+        }
+        uint64_t &word = m_words[wordIndex(index)];
+        bool oldValue = word & bitMask(index);
+        if (oldValue == value)
+            return;
+        if (value) {
+            word |= bitMask(index);
+            ++m_count;
+        } else {
+            word &= ~bitMask(index);
+            --m_count;
+        }
+    }
+    void reset(int32_t index) noexcept
+    {
+        if (index < size())
+            set(index, false);
+    }
+
+    // Returns first set bit in [left, right) range or -1 if none
+    int32_t firstSetBit(int32_t left, int32_t right) const noexcept { return firstSetBit(nullptr, left, right); }
+    // Returns first bit in [left, right) range that is set in this bitset and not set in exclude
+    int32_t firstSetBit(const DynamicBitset &exclude, int32_t left, int32_t right) const noexcept
+    {
+        return firstSetBit(&exclude, left, right);
+    }
+    // Returns last bit in [left, right) range that is set in this bitset and not set in exclude
+    int32_t lastSetBit(const DynamicBitset &exclude, int32_t left, int32_t right) const noexcept
+    {
+        left = std::max(left, 0);
+        right = std::min(right, size());
+        if (left >= right)
+            return -1;
+        for (int32_t word = (right - 1) / WORD_SIZE; word >= left / WORD_SIZE; --word) {
+            uint64_t bits = maskedWord(&exclude, word, left, right);
+            if (bits)
+                return word * WORD_SIZE + WORD_SIZE - 1 - countLeadingZeros(bits);
+        }
+        return -1;
+    }
+
+private:
+    static size_t wordIndex(int32_t index) noexcept { return static_cast<size_t>(index / WORD_SIZE); }
+    static uint64_t bitMask(int32_t index) noexcept { return 1ull << static_cast<uint32_t>(index % WORD_SIZE); }
+
+    int32_t firstSetBit(const DynamicBitset *exclude, int32_t left, int32_t right) const noexcept
+    {
+        left = std::max(left, 0);
+        right = std::min(right, size());
+        if (left >= right)
+            return -1;
+        for (int32_t word = left / WORD_SIZE; word <= (right - 1) / WORD_SIZE; ++word) {
+            uint64_t bits = maskedWord(exclude, word, left, right);
+            if (bits)
+                return word * WORD_SIZE + countTrailingZeros(bits);
+        }
+        return -1;
+    }
+
+    // Word of this bitset without excluded bits and bits outside of [left, right) range
+    uint64_t maskedWord(const DynamicBitset *exclude, int32_t word, int32_t left, int32_t right) const noexcept
+    {
+        uint64_t bits = m_words[static_cast<size_t>(word)];
+        if (exclude && word < static_cast<int32_t>(exclude->m_words.size()))
+            bits &= ~exclude->m_words[static_cast<size_t>(word)];
+        if (word == left / WORD_SIZE)
+            bits &= ~0ull << static_cast<uint32_t>(left % WORD_SIZE);
+        if (word == (right - 1) / WORD_SIZE && right % WORD_SIZE)
+            bits &= ~0ull >> static_cast<uint32_t>(WORD_SIZE - right % WORD_SIZE);
+        return bits;
+    }
+
+    std::vector<uint64_t> m_words;
+    int32_t m_count = 0;
+};
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_DYNAMICBITSET_P_H
@@ -0,0 +1,87 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_EVENTCOUNT_P_H
+#define ASYNQRO_EVENTCOUNT_P_H
+
+#include "asynqro/impl/parking.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace asynqro::detail {
+// Lets thread to park until some condition changes without any mutex.
+// Waiter announces itself with prepareWait(), rechecks its condition and either parks with wait() or
+// calls cancelWait() if condition is already satisfied. Notifier changes condition first and calls notify() after
+// that, which costs only a fence and a load if nobody announced waiting.
+// State keeps waiting flag in lowest bit and notifications epoch in other bits.
+class EventCount
+{
+public:
+    using Key = int;
+
+    EventCount() noexcept = default;
+    EventCount(const EventCount &) = delete;
+    EventCount(EventCount &&) = delete;
+    EventCount &operator=(const EventCount &) = delete;
+    EventCount &operator=(EventCount &&) = delete;
+    ~EventCount() = default;
+
+    Key prepareWait() noexcept { return m_state.fetch_or(WAITING, std::memory_order_seq_cst) | WAITING; }
+
+    void cancelWait(Key key) noexcept
+    {
+        m_state.compare_exchange_strong(key, key & ~WAITING, std::memory_order_relaxed, std::memory_order_relaxed);
+    }
+
+    // Returns after notify() that happened after prepareWait() that returned key
+    void wait(Key key) noexcept
+    {
+        while (m_state.load(std::memory_order_acquire) == key)
+            parkWhileEqual(&m_state, key, std::chrono::nanoseconds(0));
+    }
+
+    void notify() noexcept
+    {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        Key state = m_state.load(std::memory_order_relaxed);
+        if (!(state & WAITING))
+            return;
+        Key newState = 0;
+        do {
+            // Epoch is allowed to wrap around
+            newState = static_cast<Key>((static_cast<unsigned>(state) + EPOCH_UNIT) & ~static_cast<unsigned>(WAITING));
+        } while (!m_state.compare_exchange_weak(state, newState, std::memory_order_release, std::memory_order_relaxed));
+        unparkAll(&m_state);
+    }
+
+private:
+    static constexpr Key WAITING = 1;
+    static constexpr Key EPOCH_UNIT = 2;
+
+    std::atomic_int m_state{0};
+};
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_EVENTCOUNT_P_H
@@ -0,0 +1,85 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Normally this file shouldn't be included directly. asynqro/future.h already has it included
+// Moved to separate header only to keep files smaller
+#ifndef ASYNQRO_INTRUSIVEPTR_H
+#define ASYNQRO_INTRUSIVEPTR_H
+
+#include <utility>
+
+namespace asynqro::detail {
+// Smart pointer for objects with embedded reference counter.
+// T should provide ref() and deref() methods. deref() is responsible for object destruction.
+template <typename T>
+class IntrusivePtr
+{
+public:
+    IntrusivePtr() noexcept = default;
+    explicit IntrusivePtr(T *ptr) noexcept : m_ptr(ptr)
+    {
+        if (m_ptr)
+            m_ptr->ref();
+    }
+    IntrusivePtr(const IntrusivePtr &other) noexcept : m_ptr(other.m_ptr)
+    {
+        if (m_ptr)
+            m_ptr->ref();
+    }
+    IntrusivePtr(IntrusivePtr &&other) noexcept : m_ptr(other.m_ptr) { other.m_ptr = nullptr; }
+    IntrusivePtr &operator=(const IntrusivePtr &other) noexcept
+    {
+        IntrusivePtr(other).swap(*this);
+        return *this;
+    }
+    IntrusivePtr &operator=(IntrusivePtr &&other) noexcept
+    {
+        IntrusivePtr(std::move(other)).swap(*this);
+        return *this;
+    }
+    ~IntrusivePtr()
+    {
+        if (m_ptr)
+            m_ptr->deref();
+    }
+
+    void swap(IntrusivePtr &other) noexcept { std::swap(m_ptr, other.m_ptr); }
+    // Detaches pointer without dereferencing it, caller becomes responsible for held reference
+    T *release() noexcept { return std::exchange(m_ptr, nullptr); }
+
+    T *get() const noexcept { return m_ptr; }
+    T *operator->() const noexcept { return m_ptr; }
+    T &operator*() const noexcept { return *m_ptr; }
+    explicit operator bool() const noexcept { return m_ptr; }
+
+    bool operator==(const IntrusivePtr &other) const noexcept { return m_ptr == other.m_ptr; }
+    bool operator!=(const IntrusivePtr &other) const noexcept { return m_ptr != other.m_ptr; }
+
+private:
+    T *m_ptr = nullptr;
+};
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_INTRUSIVEPTR_H
@@ -0,0 +1,53 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Normally this file shouldn't be included directly. asynqro/future.h already has it included
+// Moved to separate header only to keep files smaller
+#ifndef ASYNQRO_MEMORYPOOL_H
+#define ASYNQRO_MEMORYPOOL_H
+
+#include "asynqro/impl/asynqro_export.h"
+
+#include <cstddef>
+#include <cstdint>
+
+namespace asynqro::detail {
+// Per-thread freelists of size classes for short-lived internal objects (future states mostly).
+// Memory can be deallocated in any thread, it will be reused by that thread then.
+// Objects bigger than biggest size class are passed to global allocator.
+ASYNQRO_EXPORT void *allocateFromPool(size_t size);
+ASYNQRO_EXPORT void deallocateToPool(void *ptr, size_t size) noexcept;
+
+// The same as allocateFromPool(), but also updates pool statistics
+ASYNQRO_EXPORT void *allocateFromPoolCounted(size_t size);
+} // namespace asynqro::detail
+
+namespace asynqro {
+// Pool statistics are collected only for allocations done with ASYNQRO_DEBUG_COUNT_OBJECTS defined
+int_fast64_t ASYNQRO_EXPORT instantPooledAllocations();
+int_fast64_t ASYNQRO_EXPORT instantNonPooledAllocations();
+} // namespace asynqro
+
+#endif // ASYNQRO_MEMORYPOOL_H
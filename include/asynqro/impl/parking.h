@@ -0,0 +1,47 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Normally this file shouldn't be included directly. asynqro/future.h already has it included
+// Moved to separate header only to keep files smaller
+#ifndef ASYNQRO_PARKING_H
+#define ASYNQRO_PARKING_H
+
+#include "asynqro/impl/asynqro_export.h"
+
+#include <atomic>
+#include <chrono>
+
+namespace asynqro::detail {
+// Blocks current thread while *address is equal to expected, but not longer than timeout (forever if not positive).
+// Can return spuriously, so caller should recheck its condition in loop.
+// No memory allocations are done, futex is used where it is available.
+ASYNQRO_EXPORT void parkWhileEqual(std::atomic_int *address, int expected, std::chrono::nanoseconds timeout) noexcept;
+// Wakes all threads parked on address. Should be called after address content is changed.
+ASYNQRO_EXPORT void unparkAll(std::atomic_int *address) noexcept;
+// Wakes at least one thread parked on address (can wake more of them if futex is not available)
+ASYNQRO_EXPORT void unparkOne(std::atomic_int *address) noexcept;
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_PARKING_H
@@ -35,11 +35,24 @@ namespace asynqro {
 template <typename T, typename FailureT>
 class Future;
 
+namespace detail {
+template <typename T, typename FailureT, typename Result>
+struct CoroutinePromise;
+} // namespace detail
+namespace tasks::detail {
+template <typename T, typename FailureT, typename Job>
+struct TaskFutureData;
+} // namespace tasks::detail
+
 template <typename T, typename FailureT>
 class Promise
 {
     static_assert(!std::is_same_v<T, void>, "Promise<void, _> is not allowed. Use Promise<bool, _> instead");
     static_assert(!std::is_same_v<FailureT, void>, "Promise<_, void> is not allowed. Use Promise<_, bool> instead");
+    template <typename T2, typename FailureT2, typename Result>
+    friend struct detail::CoroutinePromise;
+    template <typename T2, typename FailureT2, typename Job>
+    friend struct tasks::detail::TaskFutureData;
 
 public:
     using Value = T;
@@ -58,6 +71,7 @@ public:
     void success(const T &result) const noexcept { m_future.fillSuccess(result); }
 
 private:
+    explicit Promise(const Future<T, FailureT> &future) : m_future(future) {}
     Future<T, FailureT> m_future = Future<T, FailureT>::create();
 };
 
@@ -0,0 +1,78 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_SHARDEDCOUNTER_P_H
+#define ASYNQRO_SHARDEDCOUNTER_P_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+namespace asynqro::detail {
+static constexpr size_t CACHE_LINE_SIZE = 64;
+
+// Counter that is often changed from lots of threads and rarely read.
+// Each thread changes only its own shard, so threads don't fight for the same cache line.
+// Single shard can become negative, only sum of all shards makes sense.
+class ShardedCounter
+{
+public:
+    static constexpr size_t SHARDS_COUNT = 64;
+
+    void add(int_fast32_t value) noexcept
+    {
+        m_shards[currentShard()].value.fetch_add(value, std::memory_order_relaxed);
+    }
+    void sub(int_fast32_t value) noexcept
+    {
+        m_shards[currentShard()].value.fetch_sub(value, std::memory_order_relaxed);
+    }
+
+    int_fast32_t load() const noexcept
+    {
+        int_fast32_t result = 0;
+        for (const auto &shard : m_shards)
+            result += shard.value.load(std::memory_order_relaxed);
+        return result;
+    }
+
+private:
+    struct alignas(CACHE_LINE_SIZE) Shard
+    {
+        std::atomic_int_fast32_t value{0};
+    };
+
+    static size_t currentShard() noexcept
+    {
+        static std::atomic_size_t nextShard{0};
+        static thread_local size_t shard = nextShard.fetch_add(1, std::memory_order_relaxed) % SHARDS_COUNT;
+        return shard;
+    }
+
+    std::array<Shard, SHARDS_COUNT> m_shards;
+};
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_SHARDEDCOUNTER_P_H
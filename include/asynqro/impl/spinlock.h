@@ -25,7 +25,11 @@
 #ifndef ASYNQRO_SPINLOCK_H
 #define ASYNQRO_SPINLOCK_H
 
+#include "asynqro/impl/parking.h"
+
 #include <atomic>
+#include <chrono>
+#include <cstdint>
 #include <thread>
 
 #if defined(_MSC_VER)
@@ -35,6 +39,40 @@
 #endif
 
 namespace asynqro::detail {
+// Hints CPU that current thread is spinning
+inline void cpuRelax() noexcept
+{
+#if defined(__arm__) || defined(__aarch64__)
+    __asm__ __volatile__("yield");
+#else
+    _mm_pause();
+#endif
+}
+
+// Collected only if ASYNQRO_SPINLOCK_STATS is defined (should be the same for library and its users)
+struct SpinLockStats
+{
+    int_fast64_t acquisitions = 0;
+    int_fast64_t contendedAcquisitions = 0; // Lock was not free at first attempt
+    int_fast64_t parkedAcquisitions = 0; // Thread was parked at least once before acquiring lock
+    std::chrono::nanoseconds spinTime{0};
+    std::chrono::nanoseconds parkTime{0};
+
+    SpinLockStats &operator+=(const SpinLockStats &other) noexcept
+    {
+        acquisitions += other.acquisitions;
+        contendedAcquisitions += other.contendedAcquisitions;
+        parkedAcquisitions += other.parkedAcquisitions;
+        spinTime += other.spinTime;
+        parkTime += other.parkTime;
+        return *this;
+    }
+};
+
+// Lock spins with exponential backoff first and parks thread after that.
+// Lock is handed off directly to parked thread on unlock, so parked threads are not starved by spinning ones.
+// State word keeps lock bits and amount of threads that are registered for parking, so unlock() and parking
+// registration can't miss each other.
 class SpinLock final
 {
 public:
@@ -45,34 +83,157 @@ public:
     SpinLock &operator=(SpinLock &&) = delete;
     ~SpinLock() = default;
 
-    inline void lock() noexcept
+    inline void lock() noexcept { lockUnless(nullptr); }
+
+    // Returns false without locking if abandonLock became true while waiting
+    inline bool lockUnless(const std::atomic_bool *abandonLock) noexcept
     {
-        using namespace std::chrono_literals;
-        while (!tryLock())
-            std::this_thread::sleep_for(500us);
+        if (tryAcquire()) {
+            countAcquisition();
+            return true;
+        }
+#ifdef ASYNQRO_SPINLOCK_STATS
+        auto spinStart = std::chrono::steady_clock::now();
+        bool result = spin();
+        m_spinTime.fetch_add((std::chrono::steady_clock::now() - spinStart).count(), std::memory_order_relaxed);
+        if (result) {
+            countAcquisition(true);
+            return true;
+        }
+        auto parkStart = std::chrono::steady_clock::now();
+        result = park(abandonLock);
+        m_parkTime.fetch_add((std::chrono::steady_clock::now() - parkStart).count(), std::memory_order_relaxed);
+        if (result)
+            countAcquisition(true, true);
+        return result;
+#else
+        return spin() || park(abandonLock);
+#endif
     }
 
     inline bool try_lock() noexcept { return tryLock(); }
 
+    // Spins for a while, but never parks
     inline bool tryLock() noexcept
     {
-        bool result = !m_lock.test_and_set(std::memory_order_acq_rel);
-        for (size_t i = 0; !result && i < 1024; ++i) {
-#if defined(__arm__) || defined(__aarch64__)
-            __asm__ __volatile__("yield");
-#else
-            _mm_pause();
+        bool result = tryAcquire() || spin();
+#ifdef ASYNQRO_SPINLOCK_STATS
+        if (result)
+            countAcquisition(true);
 #endif
-            result = !m_lock.test_and_set(std::memory_order_acq_rel);
-        }
-
         return result;
     }
 
-    inline void unlock() noexcept { m_lock.clear(std::memory_order_release); }
+    inline void unlock() noexcept
+    {
+        int state = m_state.load(std::memory_order_relaxed);
+        int newState = 0;
+        do {
+            newState = state >= PARKED_UNIT ? ((state & ~LOCK_MASK) | HANDOFF) : 0;
+        } while (!m_state.compare_exchange_weak(state, newState, std::memory_order_release, std::memory_order_relaxed));
+        if (newState & HANDOFF)
+            unparkOne(&m_state);
+    }
+
+#ifdef ASYNQRO_SPINLOCK_STATS
+    SpinLockStats stats() const noexcept
+    {
+        SpinLockStats result;
+        result.acquisitions = m_acquisitions.load(std::memory_order_relaxed);
+        result.contendedAcquisitions = m_contendedAcquisitions.load(std::memory_order_relaxed);
+        result.parkedAcquisitions = m_parkedAcquisitions.load(std::memory_order_relaxed);
+        result.spinTime = std::chrono::nanoseconds(m_spinTime.load(std::memory_order_relaxed));
+        result.parkTime = std::chrono::nanoseconds(m_parkTime.load(std::memory_order_relaxed));
+        return result;
+    }
+#endif
 
 private:
-    std::atomic_flag m_lock = ATOMIC_FLAG_INIT;
+    static constexpr int LOCKED = 1;
+    static constexpr int HANDOFF = 2; // Lock is passed to one of parked threads
+    static constexpr int LOCK_MASK = LOCKED | HANDOFF;
+    static constexpr int PARKED_UNIT = 4;
+    static constexpr uint32_t MAX_SPIN_PAUSES = 512;
+    // Used only to recheck abandon flag
+    static constexpr std::chrono::milliseconds ABANDONABLE_PARK_TIMEOUT{1};
+
+    inline bool tryAcquire() noexcept
+    {
+        int state = m_state.load(std::memory_order_relaxed);
+        return !(state & LOCK_MASK)
+               && m_state.compare_exchange_strong(state, state | LOCKED, std::memory_order_acquire,
+                                                  std::memory_order_relaxed);
+    }
+
+    // Spinning is stopped as soon as there are parked threads, lock will be handed off to them anyway
+    inline bool spin() noexcept
+    {
+        for (uint32_t pauses = 1; pauses <= MAX_SPIN_PAUSES; pauses *= 2) {
+            for (uint32_t i = 0; i < pauses; ++i)
+                cpuRelax();
+            if (tryAcquire())
+                return true;
+            if (m_state.load(std::memory_order_relaxed) >= PARKED_UNIT)
+                return false;
+        }
+        return false;
+    }
+
+    inline bool park(const std::atomic_bool *abandonLock) noexcept
+    {
+        int state = m_state.fetch_add(PARKED_UNIT, std::memory_order_relaxed) + PARKED_UNIT;
+        while (true) {
+            // Lock can be free here only if it was unlocked before we registered
+            if (!(state & LOCK_MASK) || (state & HANDOFF)) {
+                int newState = ((state - PARKED_UNIT) & ~LOCK_MASK) | LOCKED;
+                if (m_state.compare_exchange_weak(state, newState, std::memory_order_acquire,
+                                                  std::memory_order_relaxed)) {
+                    return true;
+                }
+                continue;
+            }
+            if (abandonLock && abandonLock->load(std::memory_order_relaxed)) {
+                unregisterParked();
+                return false;
+            }
+            parkWhileEqual(&m_state, state, abandonLock ? ABANDONABLE_PARK_TIMEOUT : std::chrono::nanoseconds(0));
+            state = m_state.load(std::memory_order_relaxed);
+        }
+    }
+
+    // Lock handed off to this thread should be passed further
+    inline void unregisterParked() noexcept
+    {
+        int state = m_state.load(std::memory_order_relaxed);
+        int newState = 0;
+        do {
+            newState = state - PARKED_UNIT;
+            if ((newState & HANDOFF) && newState < PARKED_UNIT)
+                newState = 0;
+        } while (!m_state.compare_exchange_weak(state, newState, std::memory_order_release, std::memory_order_relaxed));
+        if (newState & HANDOFF)
+            unparkOne(&m_state);
+    }
+
+    inline void countAcquisition([[maybe_unused]] bool contended = false, [[maybe_unused]] bool parked = false) noexcept
+    {
+#ifdef ASYNQRO_SPINLOCK_STATS
+        m_acquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (contended)
+            m_contendedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+        if (parked)
+            m_parkedAcquisitions.fetch_add(1, std::memory_order_relaxed);
+#endif
+    }
+
+    std::atomic_int m_state{0};
+#ifdef ASYNQRO_SPINLOCK_STATS
+    std::atomic_int_fast64_t m_acquisitions{0};
+    std::atomic_int_fast64_t m_contendedAcquisitions{0};
+    std::atomic_int_fast64_t m_parkedAcquisitions{0};
+    std::atomic_int_fast64_t m_spinTime{0};
+    std::atomic_int_fast64_t m_parkTime{0};
+#endif
 };
 
 class SpinLockHolder final
@@ -80,23 +241,13 @@ class SpinLockHolder final
 public:
     explicit SpinLockHolder(SpinLock *lock) noexcept : m_lock(lock)
     {
-        m_lock = lock;
         if (m_lock)
             m_lock->lock();
     }
     explicit SpinLockHolder(SpinLock *lock, const std::atomic_bool &abandonLock) noexcept : m_lock(lock)
     {
-        using namespace std::chrono_literals;
-        m_lock = lock;
-        if (m_lock) {
-            while (!m_lock->tryLock()) {
-                if (abandonLock.load(std::memory_order_relaxed)) {
-                    m_lock = nullptr;
-                    return;
-                }
-                std::this_thread::sleep_for(500us);
-            }
-        }
+        if (m_lock && !m_lock->lockUnless(&abandonLock))
+            m_lock = nullptr;
     }
     SpinLockHolder(const SpinLockHolder &) = delete;
     SpinLockHolder(SpinLockHolder &&) = delete;
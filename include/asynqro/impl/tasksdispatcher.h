@@ -30,8 +30,12 @@
 
 #include "asynqro/future.h"
 #include "asynqro/impl/asynqro_export.h"
+#include "asynqro/impl/tasktypes.h"
 #include "asynqro/impl/typetraits.h"
 
+#include <optional>
+#include <vector>
+
 namespace asynqro::tasks {
 namespace detail {
 using namespace asynqro::detail;
@@ -56,22 +60,38 @@ struct FailureTypeIfFuture<false, T, DefaultFailure>
 template <typename T, typename DefaultFailure>
 using FailureTypeIfFuture_T = typename FailureTypeIfFuture<detail::IsSpecialization_V<T, Future>, T, DefaultFailure>::type;
 
-} // namespace detail
-
-enum class TaskType : uint8_t
+// Future state that also owns the job that should fill it.
+// TaskRunner::run() queues only pointer to it, so task and its future share single allocation and refcounter.
+template <typename T, typename FailureT, typename Job>
+struct TaskFutureData : public FutureData<T, FailureT>
 {
-    Custom = 0,
-    Intensive = 1,
-    ThreadBound = 2
-};
+    explicit TaskFutureData(Job &&job) noexcept(std::is_nothrow_move_constructible_v<Job>) : job(std::move(job))
+    {
+        this->releaseHook = &TaskFutureData::destroy;
+    }
 
-enum TaskPriority : uint8_t
-{
-    Emergency = 0x0,
-    Regular = 0x0F,
-    Background = 0xFF
+    Promise<T, FailureT> promise() noexcept
+    {
+        return Promise<T, FailureT>(Future<T, FailureT>(IntrusivePtr<FutureData<T, FailureT>>(this)));
+    }
+
+    void run() noexcept
+    {
+        if (!job)
+            return;
+        (*job)(promise());
+        // Captures are released right after run, not when last future copy is gone
+        job.reset();
+    }
+
+    std::optional<Job> job;
+
+private:
+    static void destroy(FutureData<T, FailureT> *data) noexcept { delete static_cast<TaskFutureData *>(data); }
 };
 
+} // namespace detail
+
 class TasksDispatcherPrivate;
 class Worker;
 class ASYNQRO_EXPORT TasksDispatcher
@@ -97,17 +117,33 @@ public:
 
     int_fast32_t instantUsage() const;
 
+    // In work stealing mode each worker keeps its own deque of tasks and idle workers steal from others.
+    // Only Intensive and untagged Custom tasks with regular priority are scheduled this way,
+    // tag and priority constrained tasks still go through shared queue.
+    bool workStealingEnabled() const;
+    void setWorkStealingEnabled(bool enabled);
+
     void preHeatPool(double amount = 1.0);
     void preHeatIntensivePool();
 
+#ifdef ASYNQRO_SPINLOCK_STATS
+    detail::SpinLockStats mainLockStats() const;
+    // Summed up for all workers
+    detail::SpinLockStats workersLockStats() const;
+#endif
+
 private:
     friend class TasksDispatcherPrivate;
     friend class Worker;
+    friend void detail::postContinuation(detail::TaskFunction &&f, TaskType type, int32_t tag,
+                                         TaskPriority priority) noexcept;
     template <typename FailureType>
     friend struct TaskRunner;
     TasksDispatcher();
     ~TasksDispatcher();
-    void insertTaskInfo(std::function<void()> &&wrappedTask, TaskType type, int32_t tag, TaskPriority priority) noexcept;
+    void insertTaskInfo(detail::TaskFunction &&wrappedTask, TaskType type, int32_t tag, TaskPriority priority) noexcept;
+    void insertTaskInfos(std::vector<detail::TaskFunction> &&wrappedTasks, TaskType type, int32_t tag,
+                         TaskPriority priority) noexcept;
 
     std::unique_ptr<TasksDispatcherPrivate> d_ptr;
 };
@@ -130,15 +166,62 @@ struct TaskRunner
     using Info = RunnerInfo;
     template <typename Task>
     static auto run(Task &&task, TaskType type, int32_t tag, TaskPriority priority) noexcept
+    {
+        auto [wrappedTask, promise] = wrap(std::forward<Task>(task));
+        TasksDispatcher::instance()->insertTaskInfo(std::move(wrappedTask), type, tag, priority);
+        return CancelableFuture<>::create(promise);
+    }
+
+    // All tasks are passed to dispatcher at once, so it is locked only once for whole batch
+    template <typename Tasks>
+    static auto runBatch(Tasks &&tasks, TaskType type, int32_t tag, TaskPriority priority) noexcept
+    {
+        using Task = detail::InnerType_T<std::decay_t<Tasks>>;
+        using FinalPromise = typename decltype(wrap(std::declval<Task>()))::second_type;
+        std::vector<decltype(CancelableFuture<>::create(std::declval<FinalPromise>()))> result;
+        std::vector<detail::TaskFunction> wrappedTasks;
+        result.reserve(tasks.size());
+        wrappedTasks.reserve(tasks.size());
+        for (auto &task : tasks) {
+            auto [wrappedTask, promise] = [&task]() {
+                if constexpr (std::is_lvalue_reference_v<Tasks>)
+                    return wrap(static_cast<const Task &>(task));
+                else // NOLINT(readability-else-after-return)
+                    return wrap(std::move(task));
+            }();
+            wrappedTasks.push_back(std::move(wrappedTask));
+            result.push_back(CancelableFuture<>::create(promise));
+        }
+        TasksDispatcher::instance()->insertTaskInfos(std::move(wrappedTasks), type, tag, priority);
+        return result;
+    }
+
+    template <typename Task>
+    static void runAndForget(Task &&task, TaskType type, int32_t tag, TaskPriority priority) noexcept
+    {
+        TasksDispatcher::instance()->insertTaskInfo(
+            [task = std::forward<Task>(task)]() mutable noexcept {
+                try {
+                    task();
+                } catch (...) {
+                }
+            },
+            type, tag, priority);
+    }
+
+private:
+    template <typename Task>
+    static auto wrap(Task &&task)
     {
         using RawResult = typename std::invoke_result_t<Task>;
         using NonVoidResult = detail::ValueTypeIfFuture_T<RawResult>;
         using FinalFailure =
             std::conditional_t<RunnerInfo::deferredFailureShouldBeConverted, typename RunnerInfo::PlainFailure,
                                detail::FailureTypeIfFuture_T<RawResult, typename RunnerInfo::PlainFailure>>;
-        Promise<std::conditional_t<std::is_same_v<RawResult, void>, bool, NonVoidResult>, FinalFailure> promise{};
+        using FinalValue = std::conditional_t<std::is_same_v<RawResult, void>, bool, NonVoidResult>;
+        using FinalPromise = Promise<FinalValue, FinalFailure>;
 
-        std::function<void()> f = [promise, task = std::forward<Task>(task)]() noexcept {
+        auto job = [task = std::forward<Task>(task)](const FinalPromise &promise) mutable noexcept {
             if (promise.isFilled())
                 return;
             detail::invalidateLastFailure();
@@ -167,21 +250,11 @@ struct TaskRunner
                 promise.failure(detail::exceptionFailure<FinalFailure>());
             }
         };
-        TasksDispatcher::instance()->insertTaskInfo(std::move(f), type, tag, priority);
-        return CancelableFuture<>::create(promise);
-    }
-
-    template <typename Task>
-    static void runAndForget(Task &&task, TaskType type, int32_t tag, TaskPriority priority) noexcept
-    {
-        TasksDispatcher::instance()->insertTaskInfo(
-            [task = std::forward<Task>(task)]() noexcept {
-                try {
-                    task();
-                } catch (...) {
-                }
-            },
-            type, tag, priority);
+        using Data = detail::TaskFutureData<FinalValue, FinalFailure, decltype(job)>;
+        detail::IntrusivePtr<Data> data(new Data(std::move(job)));
+        FinalPromise promise = data->promise();
+        return std::make_pair(detail::TaskFunction([data = std::move(data)]() noexcept { data->run(); }),
+                              std::move(promise));
     }
 };
 
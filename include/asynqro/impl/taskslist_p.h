@@ -25,11 +25,16 @@
 #ifndef ASYNQRO_TASKSLIST_P_H
 #define ASYNQRO_TASKSLIST_P_H
 
+#include "asynqro/impl/bitops_p.h"
 #include "asynqro/impl/tasksdispatcher.h"
 
 #include <algorithm>
-#include <list>
-#include <map>
+#include <array>
+#include <optional>
+#include <set>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
 
 namespace asynqro::tasks {
 
@@ -41,20 +46,26 @@ struct TaskInfo
         return x;
     }
     TaskInfo() noexcept {}
-    TaskInfo(std::function<void()> &&task, TaskType type, int32_t tag, TaskPriority priority)
+    TaskInfo(detail::TaskFunction &&task, TaskType type, int32_t tag, TaskPriority priority) noexcept
         : task(std::move(task)), tag(tag), type(type), priority(priority)
     {}
     ~TaskInfo() = default;
     TaskInfo(const TaskInfo &) = delete;
     TaskInfo &operator=(const TaskInfo &) = delete;
-    //TODO: C++20: mark as noexcept
-    TaskInfo(TaskInfo &&) = default;
-    TaskInfo &operator=(TaskInfo &&) = default;
+    TaskInfo(TaskInfo &&) noexcept = default;
+    TaskInfo &operator=(TaskInfo &&) noexcept = default;
+
+    // Stealable tasks are passed between workers as standalone nodes
+    static void *operator new(size_t size) { return detail::allocateFromPool(size); }
+    static void operator delete(void *ptr, size_t size) noexcept { detail::deallocateToPool(ptr, size); }
+
     bool isValid() const noexcept { return static_cast<bool>(task); }
-    std::function<void()> task;
+    detail::TaskFunction task;
     int32_t tag = 0;
     TaskType type = TaskType::Intensive;
     TaskPriority priority = TaskPriority::Regular;
+    // Set by TasksQueue to keep insertion order between different subpools
+    uint64_t sequence = 0;
 };
 
 constexpr uint64_t packPoolInfo(TaskType type, int32_t tag)
@@ -66,101 +77,405 @@ uint64_t packPoolInfo(const TaskInfo &taskInfo)
     return packPoolInfo(taskInfo.type, taskInfo.tag);
 }
 
+// Tasks ordered by priority and then by insertion order.
+// Each priority has its own bucket with tasks stored in chain of fixed size segments (ring buffer split into
+// segments), occupied buckets are marked in bitmap. Segments are recycled, so insert() and erase() of front task
+// don't allocate memory in steady state. Recycled segments are kept in cache that can be shared between lists.
+// Tasks erased from the middle of bucket are only marked as removed and are skipped during traversal.
 class TasksList
 {
-    using List = std::list<TaskInfo>;
-    using Map = std::map<uint_fast8_t, List>;
+    static constexpr uint32_t BUCKETS_COUNT = 256;
+    static constexpr uint32_t BITMAP_WORDS = BUCKETS_COUNT / 64;
+    static constexpr uint32_t SEGMENT_SIZE = 32;
+    static constexpr uint32_t MAX_OWN_CACHED_SEGMENTS = 4;
+
+    struct Segment
+    {
+        TaskInfo tasks[SEGMENT_SIZE];
+        Segment *next = nullptr;
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    struct Bucket
+    {
+        Segment *first = nullptr;
+        Segment *last = nullptr;
+        size_t size = 0; // Without removed ones
+    };
 
 public:
+    class SegmentsCache
+    {
+    public:
+        explicit SegmentsCache(uint32_t maxSize) noexcept : m_maxSize(maxSize) {}
+        SegmentsCache(const SegmentsCache &) = delete;
+        SegmentsCache(SegmentsCache &&) = delete;
+        SegmentsCache &operator=(const SegmentsCache &) = delete;
+        SegmentsCache &operator=(SegmentsCache &&) = delete;
+        ~SegmentsCache() { deleteSegments(m_segments); }
+
+    private:
+        friend class TasksList;
+        Segment *m_segments = nullptr;
+        uint32_t m_size = 0;
+        uint32_t m_maxSize;
+    };
+
     struct iterator
     {
         iterator &operator++()
         {
-            if (mapIt == owner->m_lists.end())
+            if (!segment)
                 return *this;
-            ++listIt;
-            if (listIt == mapIt->second.end()) {
-                ++mapIt;
-                while (mapIt != owner->m_lists.end() && mapIt->second.empty())
-                    ++mapIt;
-                listIt = (mapIt == owner->m_lists.end()) ? List::iterator() : mapIt->second.begin();
-            }
+            ++index;
+            *this = owner->firstValid(bucket, segment, index);
             return *this;
         }
         bool operator==(const iterator &other) const
         {
-            return owner == other.owner && mapIt == other.mapIt
-                   && (mapIt == owner->m_lists.end() || listIt == other.listIt);
+            return owner == other.owner && segment == other.segment && (!segment || index == other.index);
         }
         bool operator!=(const iterator &other) const { return !(*this == other); }
-        TaskInfo &operator*() const
-        {
-            if (mapIt == owner->m_lists.end())
-                return TaskInfo::empty();
-            const List &list = mapIt->second;
-            if (listIt == list.end())
-                return TaskInfo::empty();
-            return *listIt;
-        }
+        TaskInfo &operator*() const { return segment ? segment->tasks[index] : TaskInfo::empty(); }
         TaskInfo *operator->() const { return &operator*(); }
 
         const TasksList *owner;
-        Map::iterator mapIt;
-        List::iterator listIt;
+        uint32_t bucket;
+        Segment *segment;
+        uint32_t index;
     };
 
-    void insert(std::function<void()> &&task, TaskType type, int32_t tag, TaskPriority priority)
+    TasksList() noexcept : m_segmentsCache(&m_ownSegmentsCache) {}
+    // Cache should outlive the list
+    explicit TasksList(SegmentsCache *segmentsCache) noexcept : m_segmentsCache(segmentsCache) {}
+    TasksList(const TasksList &) = delete;
+    TasksList(TasksList &&) = delete;
+    TasksList &operator=(const TasksList &) = delete;
+    TasksList &operator=(TasksList &&) = delete;
+    ~TasksList()
     {
-        m_lists[priority].emplace_back(std::move(task), type, tag, priority);
-        ++m_size;
+        for (Bucket &bucket : m_buckets)
+            deleteSegments(bucket.first);
+    }
+
+    void insert(detail::TaskFunction &&task, TaskType type, int32_t tag, TaskPriority priority)
+    {
+        insert(TaskInfo(std::move(task), type, tag, priority));
     }
 
     void insert(TaskInfo &&taskInfo)
     {
-        m_lists[taskInfo.priority].push_back(std::move(taskInfo));
+        // Empty slots are treated as removed tasks
+        if (!taskInfo.isValid())
+            return;
+        Bucket &bucket = m_buckets[taskInfo.priority];
+        if (!bucket.last || bucket.last->end == SEGMENT_SIZE) {
+            Segment *segment = acquireSegment();
+            if (bucket.last)
+                bucket.last->next = segment;
+            else
+                bucket.first = segment;
+            bucket.last = segment;
+        }
+        bucket.last->tasks[bucket.last->end++] = std::move(taskInfo);
+        ++bucket.size;
+        m_occupied[taskInfo.priority / 64] |= (1ull << (taskInfo.priority % 64));
         ++m_size;
     }
 
     iterator erase(const iterator &it)
     {
-        if (it.mapIt != m_lists.end()) {
-            List &list = m_lists[it.mapIt->first];
-            if (it.listIt != list.end()) {
-                --m_size;
-                iterator newIt = it;
-                newIt.listIt = list.erase(newIt.listIt);
-                if (newIt.listIt == list.end()) {
-                    ++newIt.mapIt;
-                    while (newIt.mapIt != m_lists.end() && newIt.mapIt->second.empty())
-                        ++newIt.mapIt;
-                    if (newIt.mapIt == m_lists.end())
-                        return end();
-                    newIt.listIt = newIt.mapIt->second.begin();
-                }
-                return newIt;
-            }
+        if (!it.segment)
+            return it;
+        Bucket &bucket = m_buckets[it.bucket];
+        it.segment->tasks[it.index].task = nullptr;
+        --m_size;
+        if (!--bucket.size) {
+            releaseSegments(bucket.first);
+            bucket.first = bucket.last = nullptr;
+            m_occupied[it.bucket / 64] &= ~(1ull << (it.bucket % 64));
+            return firstValid(it.bucket + 1);
         }
-        return it;
+        if (it.segment != bucket.first || it.index != bucket.first->begin)
+            return firstValid(it.bucket, it.segment, it.index + 1);
+        dropRemovedFront(bucket);
+        return firstValid(it.bucket, bucket.first, bucket.first->begin);
     }
     bool empty() const { return !size(); }
     size_t size() const { return m_size; }
 
-    iterator begin()
+    iterator begin() { return firstValid(0); }
+    iterator end() { return iterator{this, BUCKETS_COUNT, nullptr, 0}; }
+
+private:
+    // Finds first not removed task in occupied bucket with index >= bucketIndex
+    iterator firstValid(uint32_t bucketIndex) const
     {
-        if (!empty()) {
-            for (auto mapIt = m_lists.begin(); mapIt != m_lists.end(); ++mapIt) {
-                if (!mapIt->second.empty())
-                    return iterator{this, mapIt, mapIt->second.begin()};
+        for (uint32_t word = bucketIndex / 64; word < BITMAP_WORDS; ++word) {
+            uint64_t bits = m_occupied[word];
+            if (word == bucketIndex / 64)
+                bits &= ~0ull << (bucketIndex % 64);
+            if (bits) {
+                uint32_t found = word * 64 + static_cast<uint32_t>(detail::countTrailingZeros(bits));
+                const Bucket &bucket = m_buckets[found];
+                return firstValid(found, bucket.first, bucket.first->begin);
             }
         }
-        return end();
+        return iterator{this, BUCKETS_COUNT, nullptr, 0};
     }
 
-    iterator end() { return iterator{this, m_lists.end(), List::iterator()}; }
+    // Bucket is guaranteed to have at least one not removed task if it is occupied
+    iterator firstValid(uint32_t bucketIndex, Segment *segment, uint32_t index) const
+    {
+        while (segment) {
+            for (; index < segment->end; ++index) {
+                if (segment->tasks[index].isValid())
+                    return iterator{this, bucketIndex, segment, index};
+            }
+            segment = segment->next;
+            index = segment ? segment->begin : 0;
+        }
+        return firstValid(bucketIndex + 1);
+    }
+
+    void dropRemovedFront(Bucket &bucket) noexcept
+    {
+        while (bucket.first) {
+            Segment *segment = bucket.first;
+            while (segment->begin < segment->end && !segment->tasks[segment->begin].isValid())
+                ++segment->begin;
+            if (segment->begin < segment->end)
+                return;
+            bucket.first = segment->next;
+            if (!bucket.first)
+                bucket.last = nullptr;
+            segment->next = nullptr;
+            releaseSegments(segment);
+        }
+    }
+
+    Segment *acquireSegment()
+    {
+        SegmentsCache &cache = *m_segmentsCache;
+        if (!cache.m_segments)
+            return new Segment;
+        Segment *result = cache.m_segments;
+        cache.m_segments = result->next;
+        result->next = nullptr;
+        --cache.m_size;
+        return result;
+    }
+
+    // Tasks in released segments are already empty, so segments can be reused as is
+    void releaseSegments(Segment *segment) noexcept
+    {
+        SegmentsCache &cache = *m_segmentsCache;
+        while (segment) {
+            Segment *next = segment->next;
+            if (cache.m_size < cache.m_maxSize) {
+                segment->begin = segment->end = 0;
+                segment->next = cache.m_segments;
+                cache.m_segments = segment;
+                ++cache.m_size;
+            } else {
+                delete segment;
+            }
+            segment = next;
+        }
+    }
+
+    static void deleteSegments(Segment *segment) noexcept
+    {
+        while (segment) {
+            Segment *next = segment->next;
+            delete segment;
+            segment = next;
+        }
+    }
+
+    std::array<Bucket, BUCKETS_COUNT> m_buckets = {};
+    std::array<uint64_t, BITMAP_WORDS> m_occupied = {};
+    SegmentsCache m_ownSegmentsCache{MAX_OWN_CACHED_SEGMENTS};
+    SegmentsCache *m_segmentsCache;
+    size_t m_size = 0;
+};
+
+// Tasks split by subpools. Each subpool keeps its own TasksList and subpools that have tasks and are not blocked
+// (paused or out of capacity) are indexed by their first task, so next task to schedule is found without
+// traversing tasks that can't be run anyway.
+// Default intensive and custom subpools are never erased, because they are emptied and refilled all the time.
+// Other subpools are erased when they are empty and not blocked, so cycling through lots of tags doesn't grow
+// the queue. Few erased subpools are kept for reuse, so tagged tasks don't allocate new subpool each time either.
+// Blocked subpools are kept even if empty to remember their state.
+class TasksQueue
+{
+    // Shared between all subpools, so it doesn't depend on number of subpools
+    static constexpr uint32_t MAX_CACHED_SEGMENTS = 64;
+    static constexpr size_t MAX_CACHED_SUBPOOLS = 4;
+
+public:
+    struct ReadySubPool
+    {
+        uint_fast8_t priority;
+        uint64_t sequence;
+        uint64_t poolInfo;
+        bool operator<(const ReadySubPool &other) const noexcept
+        {
+            return std::tie(priority, sequence, poolInfo) < std::tie(other.priority, other.sequence, other.poolInfo);
+        }
+    };
+
+    TasksQueue() { m_freeSubPools.reserve(MAX_CACHED_SUBPOOLS); }
+    TasksQueue(const TasksQueue &) = delete;
+    TasksQueue(TasksQueue &&) = delete;
+    TasksQueue &operator=(const TasksQueue &) = delete;
+    TasksQueue &operator=(TasksQueue &&) = delete;
+    ~TasksQueue() = default;
+
+    void insert(TaskInfo &&taskInfo)
+    {
+        // Invalid tasks are dropped by TasksList, so they shouldn't be counted here either
+        if (!taskInfo.isValid())
+            return;
+        taskInfo.sequence = ++m_lastSequence;
+        uint64_t poolInfo = packPoolInfo(taskInfo);
+        SubPool &subPool = acquireSubPool(poolInfo);
+        subPool.tasks.insert(std::move(taskInfo));
+        ++m_size;
+        reindex(poolInfo, subPool);
+    }
+
+    // Tasks of blocked subpool are kept in queue, but are not returned by firstReady()/nextReady()
+    void setBlocked(uint64_t poolInfo, bool blocked)
+    {
+        auto subPoolIt = m_subPools.find(poolInfo);
+        if (subPoolIt == m_subPools.end()) {
+            if (blocked)
+                acquireSubPool(poolInfo).blocked = true;
+            return;
+        }
+        if (subPoolIt->second.blocked == blocked)
+            return;
+        subPoolIt->second.blocked = blocked;
+        if (!blocked && subPoolIt->second.tasks.empty() && isErasable(poolInfo)) {
+            releaseSubPool(subPoolIt);
+            return;
+        }
+        reindex(poolInfo, subPoolIt->second);
+    }
+
+    // Ready subpools are ordered by priority and insertion order of their first tasks
+    std::optional<ReadySubPool> firstReady() const
+    {
+        if (m_ready.empty())
+            return std::nullopt;
+        return *m_ready.begin();
+    }
+
+    // Subpool with first task taken is still returned if its new first task should go after current one
+    std::optional<ReadySubPool> nextReady(const ReadySubPool &current) const
+    {
+        auto it = m_ready.upper_bound(current);
+        if (it == m_ready.end())
+            return std::nullopt;
+        return *it;
+    }
+
+    TaskInfo &front(uint64_t poolInfo)
+    {
+        auto subPoolIt = m_subPools.find(poolInfo);
+        return subPoolIt == m_subPools.end() ? TaskInfo::empty() : *subPoolIt->second.tasks.begin();
+    }
+
+    TaskInfo takeFront(uint64_t poolInfo)
+    {
+        auto subPoolIt = m_subPools.find(poolInfo);
+        if (subPoolIt == m_subPools.end() || subPoolIt->second.tasks.empty())
+            return TaskInfo();
+        SubPool &subPool = subPoolIt->second;
+        auto taskIt = subPool.tasks.begin();
+        TaskInfo result = std::move(*taskIt);
+        subPool.tasks.erase(taskIt);
+        --m_size;
+        reindex(poolInfo, subPool);
+        if (!subPool.blocked && subPool.tasks.empty() && isErasable(poolInfo))
+            releaseSubPool(subPoolIt);
+        return result;
+    }
+
+    bool empty() const { return !size(); }
+    size_t size() const { return m_size; }
+    size_t subPoolsCount() const { return m_subPools.size(); }
 
 private:
-    Map m_lists;
+    struct SubPool
+    {
+        explicit SubPool(TasksList::SegmentsCache *segmentsCache) noexcept : tasks(segmentsCache) {}
+        TasksList tasks;
+        bool blocked = false;
+        std::optional<ReadySubPool> indexed;
+        std::set<ReadySubPool>::node_type readyNode; // Kept while subpool is not indexed
+    };
+    using SubPools = std::unordered_map<uint64_t, SubPool>;
+
+    static bool isErasable(uint64_t poolInfo) noexcept
+    {
+        return poolInfo != packPoolInfo(TaskType::Intensive, 0) && poolInfo != packPoolInfo(TaskType::Custom, 0);
+    }
+
+    SubPool &acquireSubPool(uint64_t poolInfo)
+    {
+        auto subPoolIt = m_subPools.find(poolInfo);
+        if (subPoolIt != m_subPools.end())
+            return subPoolIt->second;
+        if (m_freeSubPools.empty())
+            return m_subPools.try_emplace(poolInfo, &m_segmentsCache).first->second;
+        SubPools::node_type node = std::move(m_freeSubPools.back());
+        m_freeSubPools.pop_back();
+        node.key() = poolInfo;
+        return m_subPools.insert(std::move(node)).position->second;
+    }
+
+    // Released subpool is empty, not blocked and not indexed, so it can be reused as is
+    void releaseSubPool(SubPools::iterator subPoolIt) noexcept
+    {
+        if (m_freeSubPools.size() < MAX_CACHED_SUBPOOLS)
+            m_freeSubPools.push_back(m_subPools.extract(subPoolIt));
+        else
+            m_subPools.erase(subPoolIt);
+    }
+
+    void reindex(uint64_t poolInfo, SubPool &subPool)
+    {
+        std::optional<ReadySubPool> newIndexed;
+        if (!subPool.blocked && !subPool.tasks.empty()) {
+            const TaskInfo &first = *subPool.tasks.begin();
+            newIndexed = ReadySubPool{first.priority, first.sequence, poolInfo};
+        }
+        if (subPool.indexed && newIndexed) {
+            // Node is reused, so taking task from queue never allocates
+            auto node = m_ready.extract(*subPool.indexed);
+            node.value() = *newIndexed;
+            m_ready.insert(std::move(node));
+        } else if (subPool.indexed) {
+            subPool.readyNode = m_ready.extract(*subPool.indexed);
+        } else if (newIndexed && subPool.readyNode) {
+            subPool.readyNode.value() = *newIndexed;
+            m_ready.insert(std::move(subPool.readyNode));
+        } else if (newIndexed) {
+            m_ready.insert(*newIndexed);
+        }
+        subPool.indexed = newIndexed;
+    }
+
+    // Declared before subpools, so it is destroyed after all lists that use it
+    TasksList::SegmentsCache m_segmentsCache{MAX_CACHED_SEGMENTS};
+    SubPools m_subPools;
+    std::vector<SubPools::node_type> m_freeSubPools;
+    std::set<ReadySubPool> m_ready;
     size_t m_size = 0;
+    uint64_t m_lastSequence = 0;
 };
 } // namespace asynqro::tasks
 #endif // ASYNQRO_TASKSLIST_P_H
@@ -0,0 +1,64 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+
+// Normally this file shouldn't be included directly. asynqro/future.h already has it included
+// Moved to separate header only to keep files smaller
+#ifndef ASYNQRO_TASKTYPES_H
+#define ASYNQRO_TASKTYPES_H
+
+#include "asynqro/impl/asynqro_export.h"
+#include "asynqro/impl/uniquefunction.h"
+
+#include <cstdint>
+
+namespace asynqro::tasks {
+enum class TaskType : uint8_t
+{
+    Custom = 0,
+    Intensive = 1,
+    ThreadBound = 2
+};
+
+enum TaskPriority : uint8_t
+{
+    Emergency = 0x0,
+    Regular = 0x0F,
+    Background = 0xFF
+};
+
+namespace detail {
+// Move-only holder of scheduled task.
+// Buffer is big enough to keep TaskRunner wrapper (promise and user task) inline for tasks from tasks.h
+// and for user tasks with captures up to ~100 bytes, so most of run() calls don't allocate for it.
+using TaskFunction = asynqro::detail::UniqueFunction<void(), 128>;
+
+// Entry points to tasks dispatcher for Future continuations that should be run in specific subpool
+ASYNQRO_EXPORT void postContinuation(TaskFunction &&f, TaskType type, int32_t tag, TaskPriority priority) noexcept;
+// Returns true if current thread is a worker that runs task from the same subpool right now
+ASYNQRO_EXPORT bool isCurrentWorkerInSubPool(TaskType type, int32_t tag) noexcept;
+} // namespace detail
+} // namespace asynqro::tasks
+
+#endif // ASYNQRO_TASKTYPES_H
@@ -0,0 +1,163 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_UNIQUEFUNCTION_H
+#define ASYNQRO_UNIQUEFUNCTION_H
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace asynqro::detail {
+template <typename Signature, size_t Size = 64>
+class UniqueFunction;
+
+// Move-only replacement for std::function.
+// Callables that fit into Size bytes (including dispatch pointer) and are nothrow movable are stored inline,
+// all others are allocated on heap.
+template <typename R, typename... Args, size_t Size>
+class UniqueFunction<R(Args...), Size>
+{
+    struct Operations
+    {
+        R (*invoke)(void *, Args &&...);
+        void (*relocate)(void *, void *) noexcept;
+        void (*destroy)(void *) noexcept;
+    };
+
+    static constexpr size_t BUFFER_SIZE = Size - alignof(std::max_align_t);
+    static_assert(Size >= 2 * alignof(std::max_align_t), "UniqueFunction size is too small");
+
+    template <typename F>
+    static constexpr bool isStoredInline = sizeof(F) <= BUFFER_SIZE && alignof(F) <= alignof(std::max_align_t)
+                                           && std::is_nothrow_move_constructible_v<F>;
+
+    template <typename F>
+    struct InlineOperations
+    {
+        static R invoke(void *storage, Args &&... args)
+        {
+            return (*static_cast<F *>(storage))(std::forward<Args>(args)...);
+        }
+        static void relocate(void *dest, void *src) noexcept
+        {
+            new (dest) F(std::move(*static_cast<F *>(src)));
+            static_cast<F *>(src)->~F();
+        }
+        static void destroy(void *storage) noexcept { static_cast<F *>(storage)->~F(); }
+        static constexpr Operations operations = {&invoke, &relocate, &destroy};
+    };
+
+    template <typename F>
+    struct HeapOperations
+    {
+        static R invoke(void *storage, Args &&... args)
+        {
+            return (**static_cast<F **>(storage))(std::forward<Args>(args)...);
+        }
+        static void relocate(void *dest, void *src) noexcept
+        {
+            new (dest) F *(*static_cast<F **>(src));
+        }
+        static void destroy(void *storage) noexcept { delete *static_cast<F **>(storage); }
+        static constexpr Operations operations = {&invoke, &relocate, &destroy};
+    };
+
+public:
+    UniqueFunction() noexcept = default;
+    UniqueFunction(std::nullptr_t) noexcept {} // NOLINT(google-explicit-constructor)
+
+    template <typename Func, typename F = std::decay_t<Func>,
+              typename = std::enable_if_t<!std::is_same_v<F, UniqueFunction> && std::is_invocable_r_v<R, F &, Args...>>>
+    UniqueFunction(Func &&f) // NOLINT(google-explicit-constructor, bugprone-forwarding-reference-overload)
+    {
+        if constexpr (isStoredInline<F>) {
+            new (m_storage) F(std::forward<Func>(f));
+            m_operations = &InlineOperations<F>::operations;
+        } else { // NOLINT(readability-misleading-indentation)
+            new (m_storage) F *(new F(std::forward<Func>(f)));
+            m_operations = &HeapOperations<F>::operations;
+        }
+    }
+
+    UniqueFunction(const UniqueFunction &) = delete;
+    UniqueFunction &operator=(const UniqueFunction &) = delete;
+
+    UniqueFunction(UniqueFunction &&other) noexcept
+    {
+        if (other.m_operations) {
+            other.m_operations->relocate(m_storage, other.m_storage);
+            m_operations = other.m_operations;
+            other.m_operations = nullptr;
+        }
+    }
+
+    UniqueFunction &operator=(UniqueFunction &&other) noexcept
+    {
+        if (this != &other) {
+            reset();
+            if (other.m_operations) {
+                other.m_operations->relocate(m_storage, other.m_storage);
+                m_operations = other.m_operations;
+                other.m_operations = nullptr;
+            }
+        }
+        return *this;
+    }
+
+    UniqueFunction &operator=(std::nullptr_t) noexcept
+    {
+        reset();
+        return *this;
+    }
+
+    ~UniqueFunction() { reset(); }
+
+    explicit operator bool() const noexcept { return m_operations; }
+
+    // Stored callable is treated as mutable state, the same way as std::function does it
+    R operator()(Args... args) const { return m_operations->invoke(m_storage, std::forward<Args>(args)...); }
+
+    template <typename F>
+    static constexpr bool storesInline() noexcept
+    {
+        return isStoredInline<std::decay_t<F>>;
+    }
+
+private:
+    void reset() noexcept
+    {
+        if (m_operations) {
+            m_operations->destroy(m_storage);
+            m_operations = nullptr;
+        }
+    }
+
+    alignas(std::max_align_t) mutable unsigned char m_storage[BUFFER_SIZE];
+    const Operations *m_operations = nullptr;
+};
+} // namespace asynqro::detail
+
+#endif // ASYNQRO_UNIQUEFUNCTION_H
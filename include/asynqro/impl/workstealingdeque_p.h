@@ -0,0 +1,138 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_WORKSTEALINGDEQUE_P_H
+#define ASYNQRO_WORKSTEALINGDEQUE_P_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+namespace asynqro::tasks::detail {
+// Chase-Lev deque (in form described in "Correct and Efficient Work-Stealing for Weak Memory Models" by Le et al.)
+// Only owner thread is allowed to call push() and pop(), they work with bottom end of deque.
+// Any thread can call steal(), it takes elements from top end.
+// Deque doesn't own stored pointers.
+template <typename T>
+class WorkStealingDeque
+{
+public:
+    explicit WorkStealingDeque(int64_t initialCapacity = 64) : m_buffer(new Buffer(initialCapacity))
+    {
+        m_retired.emplace_back(m_buffer.load(std::memory_order_relaxed));
+    }
+    WorkStealingDeque(const WorkStealingDeque &) = delete;
+    WorkStealingDeque(WorkStealingDeque &&) = delete;
+    WorkStealingDeque &operator=(const WorkStealingDeque &) = delete;
+    WorkStealingDeque &operator=(WorkStealingDeque &&) = delete;
+    ~WorkStealingDeque() = default;
+
+    // Can throw only if buffer needs to grow and there is not enough memory for it
+    void push(T *value)
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed);
+        int64_t top = m_top.load(std::memory_order_acquire);
+        Buffer *buffer = m_buffer.load(std::memory_order_relaxed);
+        if (bottom - top > buffer->capacity - 1)
+            buffer = grow(buffer, bottom, top);
+        buffer->put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_bottom.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    T *pop() noexcept
+    {
+        int64_t bottom = m_bottom.load(std::memory_order_relaxed) - 1;
+        Buffer *buffer = m_buffer.load(std::memory_order_relaxed);
+        m_bottom.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = m_top.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T *result = buffer->get(bottom);
+        if (top == bottom) {
+            if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                result = nullptr;
+            m_bottom.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return result;
+    }
+
+    // Returns nullptr both if deque is empty and if race with other thief or owner was lost
+    T *steal() noexcept
+    {
+        int64_t top = m_top.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = m_bottom.load(std::memory_order_acquire);
+        if (top >= bottom)
+            return nullptr;
+        T *result = m_buffer.load(std::memory_order_acquire)->get(top);
+        if (!m_top.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return result;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_bottom.load(std::memory_order_relaxed) <= m_top.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Buffer
+    {
+        explicit Buffer(int64_t capacity)
+            : capacity(capacity), data(new std::atomic<T *>[static_cast<size_t>(capacity)])
+        {}
+        T *get(int64_t index) const noexcept { return data[index & (capacity - 1)].load(std::memory_order_relaxed); }
+        void put(int64_t index, T *value) noexcept
+        {
+            data[index & (capacity - 1)].store(value, std::memory_order_relaxed);
+        }
+
+        const int64_t capacity;
+        std::unique_ptr<std::atomic<T *>[]> data;
+    };
+
+    Buffer *grow(Buffer *buffer, int64_t bottom, int64_t top)
+    {
+        // Thieves can still read from old buffers, so they are released only with deque itself
+        m_retired.emplace_back(new Buffer(buffer->capacity * 2));
+        Buffer *newBuffer = m_retired.back().get();
+        for (int64_t i = top; i < bottom; ++i)
+            newBuffer->put(i, buffer->get(i));
+        m_buffer.store(newBuffer, std::memory_order_release);
+        return newBuffer;
+    }
+
+    alignas(64) std::atomic<int64_t> m_top{0};
+    alignas(64) std::atomic<int64_t> m_bottom{0};
+    std::atomic<Buffer *> m_buffer;
+    std::vector<std::unique_ptr<Buffer>> m_retired;
+};
+} // namespace asynqro::tasks::detail
+#endif // ASYNQRO_WORKSTEALINGDEQUE_P_H
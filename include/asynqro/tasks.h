@@ -30,7 +30,11 @@
 #include "asynqro/impl/tasksdispatcher.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <memory>
+#include <optional>
+#include <vector>
 
 namespace asynqro {
 namespace tasks {
@@ -70,6 +74,219 @@ public:
     }
 };
 
+// Range of indices is split into chunks that are taken by participants until it is drained.
+// Chunks are guided: each one is a part of what is left, but not smaller than minChunkSize,
+// so first chunks are big and the tail is split finely enough to balance uneven elements.
+class ChunksCursor
+{
+public:
+    ChunksCursor(int64_t amount, int64_t minChunkSize, int32_t participants) noexcept
+        : m_amount(amount), m_minChunkSize(std::max<int64_t>(1, minChunkSize)),
+          m_divider(2 * static_cast<int64_t>(std::max(1, participants)))
+    {}
+
+    // Returns false if range is drained
+    bool next(int64_t &begin, int64_t &end) noexcept
+    {
+        int64_t current = m_next.load(std::memory_order_relaxed);
+        do {
+            if (current >= m_amount)
+                return false;
+            end = std::min(m_amount, current + std::max(m_minChunkSize, (m_amount - current) / m_divider));
+        } while (!m_next.compare_exchange_weak(current, end, std::memory_order_relaxed));
+        begin = current;
+        return true;
+    }
+
+    void drain() noexcept { m_next.store(m_amount, std::memory_order_relaxed); }
+
+private:
+    std::atomic_int64_t m_next{0};
+    int64_t m_amount;
+    int64_t m_minChunkSize;
+    int64_t m_divider;
+};
+
+// Tracks helper tasks that work on chunks. Once closed, no one can join anymore
+// and close() waits for all already joined ones to leave.
+class ChunksParticipants
+{
+public:
+    bool join() noexcept
+    {
+        int state = m_state.load(std::memory_order_relaxed);
+        do {
+            if (state & CLOSED)
+                return false;
+        } while (!m_state.compare_exchange_weak(state, state + 1, std::memory_order_acquire,
+                                                std::memory_order_relaxed));
+        return true;
+    }
+
+    void leave() noexcept
+    {
+        if (m_state.fetch_sub(1, std::memory_order_acq_rel) == (CLOSED | 1))
+            unparkAll(&m_state);
+    }
+
+    void close() noexcept
+    {
+        int state = m_state.fetch_or(CLOSED, std::memory_order_acq_rel) | CLOSED;
+        while (state != CLOSED) {
+            parkWhileEqual(&m_state, state, std::chrono::nanoseconds(0));
+            state = m_state.load(std::memory_order_acquire);
+        }
+    }
+
+private:
+    static constexpr int CLOSED = 1 << 30;
+    std::atomic_int m_state{0};
+};
+
+// Runs body(begin, end) for chunks of [0, amount) both in current thread and in helper tasks scheduled to the
+// same subpool. Helpers are not waited for if they are not started before range is drained, so current thread never
+// blocks on tasks that wait for a free slot. Returns first failure that happened in body.
+template <typename Runner, typename Body>
+std::optional<typename Runner::Info::PlainFailure> runChunked(int64_t amount, int64_t minChunkSize, TaskType type,
+                                                              int32_t tag, TaskPriority priority, Body &body) noexcept
+{
+    using PlainFailure = typename Runner::Info::PlainFailure;
+    struct State
+    {
+        State(int64_t amount, int64_t minChunkSize, int32_t participants, Body *body) noexcept
+            : cursor(amount, minChunkSize, participants), body(body)
+        {}
+
+        void fail(PlainFailure &&reason) noexcept
+        {
+            cursor.drain();
+            SpinLockHolder lock(&failureLock);
+            if (!failure)
+                failure.emplace(std::move(reason));
+        }
+
+        void participate() noexcept
+        {
+            invalidateLastFailure();
+            int64_t begin = 0;
+            int64_t end = 0;
+            try {
+                while (cursor.next(begin, end)) {
+                    (*body)(begin, end);
+                    if (hasLastFailure()) {
+                        fail(lastFailure<PlainFailure>());
+                        break;
+                    }
+                }
+            } catch (const std::exception &e) {
+                fail(exceptionFailure<PlainFailure>(e));
+            } catch (...) {
+                fail(exceptionFailure<PlainFailure>());
+            }
+            invalidateLastFailure();
+        }
+
+        ChunksCursor cursor;
+        ChunksParticipants participants;
+        SpinLock failureLock;
+        std::optional<PlainFailure> failure;
+        Body *body;
+    };
+
+    if (amount <= 0)
+        return std::nullopt;
+    minChunkSize = std::max<int64_t>(1, minChunkSize);
+    int64_t maxParticipants = (amount - 1) / minChunkSize + 1;
+    auto participantsCount = static_cast<int32_t>(
+        std::clamp<int64_t>(TasksDispatcher::instance()->subPoolCapacity(type, tag), 1, maxParticipants));
+    auto state = std::make_shared<State>(amount, minChunkSize, participantsCount, &body);
+    if (participantsCount > 1) {
+        auto helper = [state]() {
+            if (!state->participants.join())
+                return;
+            state->participate();
+            state->participants.leave();
+        };
+        Runner::runBatch(std::vector<decltype(helper)>(static_cast<size_t>(participantsCount - 1), helper), type, tag,
+                         priority);
+    }
+    state->participate();
+    state->participants.close();
+    return std::move(state->failure);
+}
+
+// Fixed split of [0, amount) into clusters of equal size (except the last one).
+// Few clusters per subpool slot is enough for balancing, because clusters are still taken dynamically.
+struct Clusters
+{
+    Clusters(int64_t amount, int64_t minClusterSize, TaskType type, int32_t tag) noexcept : amount(amount)
+    {
+        minClusterSize = std::max<int64_t>(1, minClusterSize);
+        count = std::clamp<int64_t>(8 * TasksDispatcher::instance()->subPoolCapacity(type, tag), 1,
+                                    (amount - 1) / minClusterSize + 1);
+        size = (amount - 1) / count + 1;
+        count = (amount - 1) / size + 1;
+    }
+
+    int64_t begin(int64_t cluster) const noexcept { return cluster * size; }
+    int64_t end(int64_t cluster) const noexcept { return std::min(amount, (cluster + 1) * size); }
+
+    int64_t amount;
+    int64_t size;
+    int64_t count;
+};
+
+// Partial results of clusters that are combined pairwise as soon as both siblings are ready.
+// Whoever finishes second merges right sibling into left one and continues to upper level, so combining
+// is spread across participants and keeps clusters order (combine is only required to be associative).
+template <typename Acc>
+class ReduceTree
+{
+public:
+    // Each partial occupies its own cache line to avoid false sharing between participants
+    struct alignas(64) Partial
+    {
+        Acc value;
+    };
+
+    ReduceTree(int64_t leavesCount, const Acc &identity)
+        : m_leavesCount(leavesCount), m_partials(static_cast<size_t>(leavesCount), Partial{identity})
+    {
+        int64_t nodesCount = 0;
+        for (int64_t width = 1; width < leavesCount; width *= 2) {
+            m_levelOffsets.push_back(nodesCount);
+            nodesCount += (leavesCount - 1) / (2 * width) + 1;
+        }
+        m_arrived = std::vector<std::atomic_bool>(static_cast<size_t>(nodesCount));
+    }
+
+    template <typename Combine>
+    void complete(int64_t leaf, Acc &&value, Combine &combine)
+    {
+        m_partials[static_cast<size_t>(leaf)].value = std::move(value);
+        for (size_t level = 0; level < m_levelOffsets.size(); ++level) {
+            int64_t width = int64_t(1) << level;
+            int64_t left = leaf & ~(2 * width - 1);
+            int64_t right = left + width;
+            if (right >= m_leavesCount)
+                continue;
+            auto node = static_cast<size_t>(m_levelOffsets[level] + left / (2 * width));
+            if (!m_arrived[node].exchange(true, std::memory_order_acq_rel))
+                return;
+            Acc &leftValue = m_partials[static_cast<size_t>(left)].value;
+            leftValue = combine(std::move(leftValue), std::move(m_partials[static_cast<size_t>(right)].value));
+        }
+    }
+
+    Acc &&result() noexcept { return std::move(m_partials[0].value); }
+
+private:
+    int64_t m_leavesCount;
+    std::vector<Partial> m_partials;
+    std::vector<int64_t> m_levelOffsets;
+    std::vector<std::atomic_bool> m_arrived;
+};
+
 struct DefaultRunnerInfo
 {
     using PlainFailure = std::string;
@@ -129,6 +346,16 @@ void runAndForget(TaskPriority priority, Task &&task) noexcept
     return Runner::runAndForget(std::forward<Task>(task), TaskType::Intensive, 0, priority);
 }
 
+// Schedules all tasks from container with single dispatcher lock acquisition.
+// Returns std::vector with the same CancelableFutures run() would return for each of them.
+template <typename Runner = detail::DefaultRunner, typename C, typename Task = detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<Task>>>
+auto runBatch(C &&tasks, TaskType type = TaskType::Intensive, int32_t tag = 0,
+              TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    return Runner::runBatch(std::forward<C>(tasks), type, tag, priority);
+}
+
 template <typename Runner = detail::DefaultRunner, typename C, typename T = detail::InnerType_T<C>, typename Task,
           typename = std::enable_if_t<std::is_invocable_v<Task, T> || std::is_invocable_v<Task, long long, T>>>
 auto run(const C &data, Task &&f, TaskType type = TaskType::Intensive, int32_t tag = 0,
@@ -139,16 +366,17 @@ auto run(const C &data, Task &&f, TaskType type = TaskType::Intensive, int32_t t
     if (data.empty())
         return Helper::SequenceFinalResult::successful();
 
-    detail::WithInnerType_T<C, typename Helper::RunResult> futures;
-    if constexpr (Helper::isIndexed) {
-        futures = traverse::map(data, [f = std::forward<Task>(f), type, tag, priority](long long index, const T &x) {
-            return Runner::run([index, x, f]() { return f(index, x); }, type, tag, priority).future();
-        });
-    } else { // NOLINT(readability-misleading-indentation)
-        futures = traverse::map(data, [f = std::forward<Task>(f), type, tag, priority](const T &x) {
-            return Runner::run([x, f]() { return f(x); }, type, tag, priority).future();
-        });
-    }
+    auto jobFactory = [&f](long long index, const T &x) {
+        if constexpr (Helper::isIndexed)
+            return [index, x, f]() { return f(index, x); };
+        else // NOLINT(readability-else-after-return)
+            return [x, f]() { return f(x); };
+    };
+    using Job = std::invoke_result_t<decltype(jobFactory), long long, const T &>;
+    auto jobs = traverse::map(data, jobFactory, std::vector<Job>());
+    auto cancelableFutures = Runner::runBatch(std::move(jobs), type, tag, priority);
+    auto futures = traverse::map(cancelableFutures, [](const auto &x) { return x.future(); },
+                                 detail::WithInnerType_T<C, typename Helper::RunResult>());
 
     return Helper::finalizeResult(Helper::RunResult::sequence(futures));
 }
@@ -175,51 +403,106 @@ ResultFuture clusteredRun(C &&data, Task &&f, int64_t minClusterSize = 1, TaskTy
 
     return Runner::run(
         [data = std::forward<C>(data), f = std::forward<Task>(f), minClusterSize, type, tag, priority]() -> Result {
-            int64_t amount = data.size();
-            int32_t capacity = TasksDispatcher::instance()->subPoolCapacity(type, tag);
-            capacity = std::min(static_cast<int32_t>(ceil(amount / static_cast<double>(minClusterSize))), capacity);
-            int32_t clusterSize = static_cast<int32_t>(amount / capacity);
-            --capacity; // Last cluster will be processed in managing thread
+            auto amount = static_cast<int64_t>(data.size());
             Result result;
-            result.resize(amount);
-            std::vector<Future<bool, typename Runner::Info::PlainFailure>> futures;
-            futures.reserve(static_cast<uint32_t>(capacity));
-            for (int32_t job = 0; job < capacity; ++job) {
-                futures.push_back(Runner::run(
-                    [&data, &f, &result, job, clusterSize]() {
-                        const auto right = (job + 1) * clusterSize;
-                        for (int32_t i = job * clusterSize; i < right && !detail::hasLastFailure(); ++i)
-                            result[i] = f(data[i]);
-                    },
-                    type, tag, priority));
-            }
-            typename Runner::Info::PlainFailure localFailure;
-            bool localFailureHappened = false;
-            try {
-                for (int32_t i = capacity * clusterSize; i < amount && !detail::hasLastFailure(); ++i)
+            result.resize(data.size());
+            auto body = [&data, &f, &result](int64_t begin, int64_t end) {
+                for (int64_t i = begin; i < end && !detail::hasLastFailure(); ++i)
                     result[i] = f(data[i]);
-                localFailure = detail::lastFailure<typename Runner::Info::PlainFailure>();
-                localFailureHappened = detail::hasLastFailure();
-            } catch (const std::exception &e) {
-                localFailure = detail::exceptionFailure<typename Runner::Info::PlainFailure>(e);
-                localFailureHappened = true;
-            } catch (...) {
-                localFailure = detail::exceptionFailure<typename Runner::Info::PlainFailure>();
-                localFailureHappened = true;
-            }
-            detail::invalidateLastFailure();
-            for (const auto &future : futures)
-                future.wait();
-            if (localFailureHappened)
-                return WithFailure<typename Runner::Info::PlainFailure>(localFailure);
-            for (const auto &future : futures) {
-                if (future.isFailed())
-                    return WithFailure<typename Runner::Info::PlainFailure>(future.failureReason());
-            }
+            };
+            auto failure = detail::runChunked<Runner>(amount, minClusterSize, type, tag, priority, body);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
             return result;
         },
         type, tag, priority);
 }
+
+// Borrowed memory version of clusteredRun. Nothing is copied, output[i] = f(input[i]) is written directly to caller
+// memory. Both input and output should be alive until returned Future is filled.
+template <typename Runner = detail::DefaultRunner, typename T, typename U, typename Task,
+          typename = std::enable_if_t<std::is_invocable_v<Task, const T &>>>
+Future<bool, typename Runner::Info::PlainFailure>
+clusteredRun(const T *input, int64_t size, U *output, Task &&f, int64_t minClusterSize = 1,
+             TaskType type = TaskType::Intensive, int32_t tag = 0, TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    if (size <= 0)
+        return Future<bool, typename Runner::Info::PlainFailure>::successful(true);
+    return Runner::run(
+        [input, size, output, f = std::forward<Task>(f), minClusterSize, type, tag, priority]() mutable -> bool {
+            auto body = [input, output, &f](int64_t begin, int64_t end) {
+                for (int64_t i = begin; i < end && !detail::hasLastFailure(); ++i)
+                    output[i] = f(input[i]);
+            };
+            auto failure = detail::runChunked<Runner>(size, minClusterSize, type, tag, priority, body);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return true;
+        },
+        type, tag, priority);
+}
+
+// Runs f(index) for each index in [begin, end) using the same dynamic clustering as clusteredRun.
+// Chunks are not smaller than grain. Nothing is copied except f itself.
+template <typename Runner = detail::DefaultRunner, typename Task,
+          typename = std::enable_if_t<std::is_invocable_v<Task, int64_t>>>
+Future<bool, typename Runner::Info::PlainFailure>
+parallelFor(int64_t begin, int64_t end, int64_t grain, Task &&f, TaskType type = TaskType::Intensive, int32_t tag = 0,
+            TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    if (end <= begin)
+        return Future<bool, typename Runner::Info::PlainFailure>::successful(true);
+    return Runner::run(
+        [begin, end, grain, f = std::forward<Task>(f), type, tag, priority]() mutable -> bool {
+            auto body = [begin, &f](int64_t chunkBegin, int64_t chunkEnd) {
+                for (int64_t i = chunkBegin; i < chunkEnd && !detail::hasLastFailure(); ++i)
+                    f(begin + i);
+            };
+            auto failure = detail::runChunked<Runner>(end - begin, grain, type, tag, priority, body);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return true;
+        },
+        type, tag, priority);
+}
+
+// Maps each element and reduces results with combine, starting from identity in each cluster.
+// Clusters are reduced locally and their partial results are combined in a tree, so only O(clusters) memory is used.
+// Combine should be associative and should accept both (Acc, mapped value) and (Acc, Acc).
+template <typename Runner = detail::DefaultRunner, typename C, typename MapFn, typename CombineFn, typename Acc,
+          typename T = detail::InnerType_T<std::decay_t<C>>,
+          typename = std::enable_if_t<std::is_invocable_v<MapFn, T> && std::is_invocable_v<CombineFn, Acc, Acc>>>
+Future<Acc, typename Runner::Info::PlainFailure>
+clusteredReduce(C &&data, MapFn &&mapFn, CombineFn &&combineFn, Acc identity, int64_t minClusterSize = 1,
+                TaskType type = TaskType::Intensive, int32_t tag = 0,
+                TaskPriority priority = TaskPriority::Regular) noexcept
+{
+    if (data.empty())
+        return Future<Acc, typename Runner::Info::PlainFailure>::successful(std::move(identity));
+
+    return Runner::run(
+        [data = std::forward<C>(data), mapFn = std::forward<MapFn>(mapFn), combineFn = std::forward<CombineFn>(combineFn),
+         identity = std::move(identity), minClusterSize, type, tag, priority]() mutable -> Acc {
+            detail::Clusters clusters(static_cast<int64_t>(data.size()), minClusterSize, type, tag);
+            detail::ReduceTree<Acc> tree(clusters.count, identity);
+            auto body = [&](int64_t begin, int64_t end) {
+                for (int64_t cluster = begin; cluster < end; ++cluster) {
+                    Acc acc = identity;
+                    for (int64_t i = clusters.begin(cluster); i < clusters.end(cluster); ++i) {
+                        acc = combineFn(std::move(acc), mapFn(data[i]));
+                        if (detail::hasLastFailure())
+                            return;
+                    }
+                    tree.complete(cluster, std::move(acc), combineFn);
+                }
+            };
+            auto failure = detail::runChunked<Runner>(clusters.count, 1, type, tag, priority, body);
+            if (failure)
+                return WithFailure<typename Runner::Info::PlainFailure>(std::move(*failure));
+            return tree.result();
+        },
+        type, tag, priority);
+}
 } // namespace tasks
 
 template <typename T, typename FailureT>
@@ -228,11 +511,20 @@ struct Trampoline
     explicit Trampoline(Future<T, FailureT> f = Future<T, FailureT>()) noexcept { m_future = std::move(f); }
     operator Future<T, FailureT>() noexcept // NOLINT(google-explicit-constructor)
     {
+        using Data = detail::FutureData<T, FailureT>;
         Future<T, FailureT> result = Future<T, FailureT>::create();
-        m_future
-            .onSuccess([result](const T &v) noexcept { tasks::runAndForget([result, v] { result.fillSuccess(v); }); })
-            .onFailure(
-                [result](const FailureT &f) noexcept { tasks::runAndForget([result, f] { result.fillFailure(f); }); });
+        // Result is always filled from outermost continuation frame of the completing thread.
+        // It resets the stack same way as scheduling to thread pool did, but without context switches.
+        m_future.addContinuation([result, source = m_future.d.get()](const auto &) noexcept {
+            detail::runTrampolined(
+                [result, data = detail::IntrusivePtr<Data>(source)]() noexcept {
+                    if (data->value.index() == 1)
+                        result.fillSuccess(std::get<1>(data->value));
+                    else
+                        result.fillFailure(std::get<2>(data->value));
+                },
+                true);
+        });
         return result;
     }
 
@@ -0,0 +1,505 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#ifndef ASYNQRO_UNIQUEFUTURE_H
+#define ASYNQRO_UNIQUEFUTURE_H
+
+#include "asynqro/future.h"
+
+#include <atomic>
+#include <cassert>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+namespace asynqro {
+template <typename T, typename FailureT>
+class UniqueFuture;
+template <typename T, typename FailureT>
+class UniquePromise;
+
+namespace detail {
+enum UniqueFutureHandOff
+{
+    NothingHandedOff = 0,
+    ContinuationHandedOff = 1,
+    ValueHandedOff = 2
+};
+
+// State shared between single producer (UniquePromise) and single consumer (UniqueFuture).
+// Whoever comes second in state exchange is responsible for calling continuation.
+template <typename T, typename FailureT>
+struct UniqueFutureData
+{
+    using ValueStorage = std::variant<std::monostate, T, FailureT>;
+    using Continuation = UniqueFunction<void(ValueStorage &&)>;
+
+    UniqueFutureData() // NOLINT(modernize-use-equals-default)
+    {
+#ifdef ASYNQRO_DEBUG_COUNT_OBJECTS
+        incrementFuturesUsage();
+#endif
+    }
+    UniqueFutureData(const UniqueFutureData<T, FailureT> &) = delete;
+    UniqueFutureData(UniqueFutureData<T, FailureT> &&) = delete;
+    UniqueFutureData<T, FailureT> &operator=(const UniqueFutureData<T, FailureT> &) = delete;
+    UniqueFutureData<T, FailureT> &operator=(UniqueFutureData<T, FailureT> &&) = delete;
+    ~UniqueFutureData()
+    {
+#ifdef ASYNQRO_DEBUG_COUNT_OBJECTS
+        decrementFuturesUsage();
+#endif
+    }
+
+    static void *operator new(size_t size)
+    {
+#ifdef ASYNQRO_DEBUG_COUNT_OBJECTS
+        return allocateFromPoolCounted(size);
+#else
+        return allocateFromPool(size);
+#endif
+    }
+    static void operator delete(void *ptr, size_t size) noexcept { deallocateToPool(ptr, size); }
+    // Over-aligned data is not pooled, same as in FutureData
+    static void *operator new(size_t size, std::align_val_t alignment) { return ::operator new(size, alignment); }
+    static void operator delete(void *ptr, size_t, std::align_val_t alignment) noexcept
+    {
+        ::operator delete(ptr, alignment);
+    }
+
+    void ref() noexcept { refCount.fetch_add(1, std::memory_order_relaxed); }
+    void deref() noexcept
+    {
+        if (refCount.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            delete this;
+    }
+
+    bool isCompleted() const noexcept { return handOff.load(std::memory_order_acquire) == ValueHandedOff; }
+
+    // Producer side, should be called at most once
+    void fill(ValueStorage &&newValue) noexcept
+    {
+        try {
+            value = std::move(newValue);
+        } catch (...) {
+            // Should never happen
+        }
+        if (handOff.exchange(ValueHandedOff, std::memory_order_acq_rel) == ContinuationHandedOff)
+            runContinuation();
+    }
+
+    // Consumer side, should be called at most once
+    template <typename Func>
+    void setContinuation(Func &&f)
+    {
+        if (isCompleted()) {
+            runTrampolined([data = IntrusivePtr<UniqueFutureData<T, FailureT>>(this),
+                            f = std::forward<Func>(f)]() mutable { f(std::move(data->value)); });
+            return;
+        }
+        continuation = std::forward<Func>(f);
+        if (handOff.exchange(ContinuationHandedOff, std::memory_order_acq_rel) == ValueHandedOff)
+            runContinuation();
+    }
+
+    std::atomic_int_fast32_t refCount{0};
+    std::atomic_int handOff{NothingHandedOff};
+    ValueStorage value;
+    Continuation continuation;
+
+private:
+    void runContinuation() noexcept
+    {
+        runTrampolined([data = IntrusivePtr<UniqueFutureData<T, FailureT>>(this)]() noexcept {
+            try {
+                data->continuation(std::move(data->value));
+            } catch (...) {
+            }
+            // Releasing captures (next promise in chain mostly) right away
+            data->continuation = nullptr;
+        });
+    }
+};
+
+template <typename Result>
+struct IsUniqueFuture : std::false_type
+{};
+
+template <typename T, typename FailureT>
+struct IsUniqueFuture<UniqueFuture<T, FailureT>> : std::true_type
+{};
+
+template <typename Result>
+inline constexpr bool IsUniqueFuture_V = IsUniqueFuture<std::decay_t<Result>>::value;
+} // namespace detail
+
+// Move-only future with single consumer.
+// Value is moved to continuation instead of being copied and continuation is handed off with single atomic exchange.
+// All transformations consume this object (and should be called on rvalue), share() converts it to regular Future.
+template <typename T, typename FailureT>
+class UniqueFuture
+{
+    static_assert(!std::is_same_v<T, void>, "UniqueFuture<void, _> is not allowed. Use UniqueFuture<bool, _> instead");
+    static_assert(!std::is_same_v<FailureT, void>,
+                  "UniqueFuture<_, void> is not allowed. Use UniqueFuture<_, bool> instead");
+    template <typename T2, typename FailureT2>
+    friend class UniqueFuture;
+    friend class UniquePromise<T, FailureT>;
+
+    using Data = detail::UniqueFutureData<T, FailureT>;
+    using ValueStorage = typename Data::ValueStorage;
+
+public:
+    using Value = T;
+    using Failure = FailureT;
+    UniqueFuture() noexcept = default; // Creates invalid future, calling methods of such object will lead to assertion/segfault
+    UniqueFuture(const UniqueFuture<T, FailureT> &) = delete;
+    UniqueFuture(UniqueFuture<T, FailureT> &&) noexcept = default;
+    UniqueFuture<T, FailureT> &operator=(const UniqueFuture<T, FailureT> &) = delete;
+    UniqueFuture<T, FailureT> &operator=(UniqueFuture<T, FailureT> &&) noexcept = default;
+    ~UniqueFuture() = default;
+
+    bool isValid() const noexcept { return static_cast<bool>(d); }
+    bool isCompleted() const noexcept
+    {
+        assert(d);
+        return d->isCompleted();
+    }
+
+    Future<T, FailureT> share() && noexcept
+    {
+        assert(d);
+        Promise<T, FailureT> promise;
+        Future<T, FailureT> result = promise.future();
+        auto data = std::move(d);
+        data->setContinuation([promise](ValueStorage &&value) noexcept {
+            if (value.index() == 1)
+                promise.success(std::get<1>(std::move(value)));
+            else
+                promise.failure(std::get<2>(value));
+        });
+        return result;
+    }
+
+    template <typename Func, typename U = std::invoke_result_t<Func, T &&>>
+    UniqueFuture<U, FailureT> map(Func &&f) && noexcept
+    {
+        return std::move(*this).template chain<U, FailureT>(
+            [f = std::forward<Func>(f)](UniquePromise<U, FailureT> &result, ValueStorage &&value) mutable {
+                if (value.index() == 2) {
+                    result.failure(std::get<2>(std::move(value)));
+                    return;
+                }
+                try {
+                    result.success(f(std::get<1>(std::move(value))));
+                } catch (const std::exception &e) {
+                    result.failure(detail::exceptionFailure<FailureT>(e));
+                } catch (...) {
+                    result.failure(detail::exceptionFailure<FailureT>());
+                }
+            });
+    }
+
+    template <typename Func, typename OtherFailure = std::invoke_result_t<Func, FailureT &&>>
+    UniqueFuture<T, OtherFailure> mapFailure(Func &&f) && noexcept
+    {
+        return std::move(*this).template chain<T, OtherFailure>(
+            [f = std::forward<Func>(f)](UniquePromise<T, OtherFailure> &result, ValueStorage &&value) mutable {
+                if (value.index() == 1) {
+                    result.success(std::get<1>(std::move(value)));
+                    return;
+                }
+                try {
+                    result.failure(f(std::get<2>(std::move(value))));
+                } catch (const std::exception &e) {
+                    result.failure(detail::exceptionFailure<OtherFailure>(e));
+                } catch (...) {
+                    result.failure(detail::exceptionFailure<OtherFailure>());
+                }
+            });
+    }
+
+    // f can return UniqueFuture, Future or CancelableFuture
+    template <typename Func, typename U = typename std::decay_t<std::invoke_result_t<Func, T &&>>::Value>
+    UniqueFuture<U, FailureT> flatMap(Func &&f) && noexcept
+    {
+        return std::move(*this).template chain<U, FailureT>(
+            [f = std::forward<Func>(f)](UniquePromise<U, FailureT> &result, ValueStorage &&value) mutable {
+                if (value.index() == 2) {
+                    result.failure(std::get<2>(std::move(value)));
+                    return;
+                }
+                try {
+                    result.fillFrom(f(std::get<1>(std::move(value))));
+                } catch (const std::exception &e) {
+                    result.failure(detail::exceptionFailure<FailureT>(e));
+                } catch (...) {
+                    result.failure(detail::exceptionFailure<FailureT>());
+                }
+            });
+    }
+
+    template <typename Func>
+    auto andThen(Func &&f) && noexcept
+    {
+        return std::move(*this).flatMap([f = std::forward<Func>(f)](T &&) mutable { return f(); });
+    }
+
+    template <typename Func, typename = std::enable_if_t<std::is_invocable_v<Func, FailureT &&>>>
+    UniqueFuture<T, FailureT> recover(Func &&f) && noexcept
+    {
+        return std::move(*this).template chain<T, FailureT>(
+            [f = std::forward<Func>(f)](UniquePromise<T, FailureT> &result, ValueStorage &&value) mutable {
+                if (value.index() == 1) {
+                    result.success(std::get<1>(std::move(value)));
+                    return;
+                }
+                try {
+                    result.success(f(std::get<2>(std::move(value))));
+                } catch (const std::exception &e) {
+                    result.failure(detail::exceptionFailure<FailureT>(e));
+                } catch (...) {
+                    result.failure(detail::exceptionFailure<FailureT>());
+                }
+            });
+    }
+
+    // f can return UniqueFuture, Future or CancelableFuture
+    template <typename Func,
+              typename OtherFailure = typename std::decay_t<std::invoke_result_t<Func, FailureT &&>>::Failure>
+    UniqueFuture<T, OtherFailure> recoverWith(Func &&f) && noexcept
+    {
+        return std::move(*this).template chain<T, OtherFailure>(
+            [f = std::forward<Func>(f)](UniquePromise<T, OtherFailure> &result, ValueStorage &&value) mutable {
+                if (value.index() == 1) {
+                    result.success(std::get<1>(std::move(value)));
+                    return;
+                }
+                try {
+                    result.fillFrom(f(std::get<2>(std::move(value))));
+                } catch (const std::exception &e) {
+                    result.failure(detail::exceptionFailure<OtherFailure>(e));
+                } catch (...) {
+                    result.failure(detail::exceptionFailure<OtherFailure>());
+                }
+            });
+    }
+
+    template <typename Head, typename... Tail,
+              typename Result = detail::TypesProduct_T<T, typename Head::Value, typename Tail::Value...>,
+              typename InnerZipFailure = detail::TypesSum_T<typename Head::Failure, typename Tail::Failure...>,
+              typename NewFailure = detail::TypesSum_T<FailureT, InnerZipFailure>,
+              typename = std::enable_if_t<detail::IsUniqueFuture_V<Head> && (detail::IsUniqueFuture_V<Tail> && ...)>>
+    UniqueFuture<Result, NewFailure> zip(Head &&head, Tail &&... tail) && noexcept
+    {
+        auto zipRest = [others = std::make_tuple(std::move(head), std::move(tail)...)](T &&v) mutable noexcept {
+            auto inner = std::apply([](auto &&... x) noexcept { return zipAll(std::move(x)...); }, std::move(others))
+                             .map([v = std::move(v)](auto &&argsResult) mutable noexcept -> Result {
+                                 return std::tuple_cat(detail::AsTuple<T>::make(std::move(v)), std::move(argsResult));
+                             });
+            if constexpr (std::is_same_v<InnerZipFailure, NewFailure>)
+                return inner;
+            else
+                return std::move(inner).mapFailure(toVariantFailure<InnerZipFailure, NewFailure>);
+        };
+        if constexpr (std::is_same_v<FailureT, NewFailure>) {
+            return std::move(*this).flatMap(std::move(zipRest));
+        } else { // NOLINT(readability-else-after-return,readability-misleading-indentation)
+            return std::move(*this)
+                .mapFailure(toVariantFailure<FailureT, NewFailure>)
+                .flatMap(std::move(zipRest));
+        }
+    }
+
+    static UniqueFuture<T, FailureT> successful(T &&value) noexcept
+    {
+        UniquePromise<T, FailureT> promise;
+        UniqueFuture<T, FailureT> result = promise.future();
+        promise.success(std::move(value));
+        return result;
+    }
+
+    static UniqueFuture<T, FailureT> successful(const T &value) noexcept
+    {
+        UniquePromise<T, FailureT> promise;
+        UniqueFuture<T, FailureT> result = promise.future();
+        promise.success(value);
+        return result;
+    }
+
+    static UniqueFuture<T, FailureT> failed(const FailureT &failure) noexcept
+    {
+        UniquePromise<T, FailureT> promise;
+        UniqueFuture<T, FailureT> result = promise.future();
+        promise.failure(failure);
+        return result;
+    }
+
+private:
+    explicit UniqueFuture(const detail::IntrusivePtr<Data> &otherD) noexcept : d(otherD) {}
+
+    // Creates new future and hands off continuation that should fill it
+    template <typename U, typename OtherFailure, typename Func>
+    UniqueFuture<U, OtherFailure> chain(Func &&f) && noexcept
+    {
+        assert(d);
+        UniquePromise<U, OtherFailure> promise;
+        UniqueFuture<U, OtherFailure> result = promise.future();
+        auto data = std::move(d);
+        try {
+            data->setContinuation(
+                [promise = std::move(promise), f = std::forward<Func>(f)](ValueStorage &&value) mutable noexcept {
+                    f(promise, std::move(value));
+                });
+        } catch (const std::exception &e) {
+            return UniqueFuture<U, OtherFailure>::failed(detail::exceptionFailure<OtherFailure>(e));
+        } catch (...) {
+            return UniqueFuture<U, OtherFailure>::failed(detail::exceptionFailure<OtherFailure>());
+        }
+        return result;
+    }
+
+    template <typename Head, typename... Others>
+    static auto zipAll(Head &&head, Others &&... others) noexcept
+    {
+        using HeadValue = typename std::decay_t<Head>::Value;
+        if constexpr (sizeof...(Others) == 0) {
+            return std::move(head).map(
+                [](HeadValue &&v) noexcept { return detail::AsTuple<HeadValue>::make(std::move(v)); });
+        } else { // NOLINT(readability-else-after-return,readability-misleading-indentation)
+            return std::move(head).zip(std::move(others)...);
+        }
+    }
+
+    template <typename From, typename To>
+    static To toVariantFailure(From &&failure) noexcept
+    {
+        return std::visit([](auto &&x) noexcept -> To { return std::forward<decltype(x)>(x); },
+                          detail::AsVariant<From>::make(std::move(failure)));
+    }
+
+    detail::IntrusivePtr<Data> d;
+};
+
+// Move-only promise for UniqueFuture. Only first fill is taken into account.
+template <typename T, typename FailureT>
+class UniquePromise
+{
+    static_assert(!std::is_same_v<T, void>, "UniquePromise<void, _> is not allowed. Use UniquePromise<bool, _> instead");
+    static_assert(!std::is_same_v<FailureT, void>,
+                  "UniquePromise<_, void> is not allowed. Use UniquePromise<_, bool> instead");
+    template <typename T2, typename FailureT2>
+    friend class UniqueFuture;
+
+    using Data = detail::UniqueFutureData<T, FailureT>;
+    using ValueStorage = typename Data::ValueStorage;
+
+public:
+    using Value = T;
+    UniquePromise() : d(new Data()) {}
+    UniquePromise(const UniquePromise<T, FailureT> &) = delete;
+    UniquePromise(UniquePromise<T, FailureT> &&other) noexcept
+        : d(std::move(other.d)), m_futureTaken(other.m_futureTaken), m_filled(other.m_filled)
+    {}
+    UniquePromise<T, FailureT> &operator=(const UniquePromise<T, FailureT> &) = delete;
+    UniquePromise<T, FailureT> &operator=(UniquePromise<T, FailureT> &&other) noexcept
+    {
+        d = std::move(other.d);
+        m_futureTaken = other.m_futureTaken;
+        m_filled = other.m_filled;
+        return *this;
+    }
+    ~UniquePromise() = default;
+
+    // Can be called only once, all subsequent calls return invalid future
+    UniqueFuture<T, FailureT> future() noexcept
+    {
+        if (m_futureTaken || !d)
+            return UniqueFuture<T, FailureT>();
+        m_futureTaken = true;
+        return UniqueFuture<T, FailureT>(d);
+    }
+
+    bool isFilled() const noexcept { return m_filled; }
+
+    void success(T &&result) noexcept
+    {
+        if (detail::hasLastFailure()) {
+            FailureT failure = detail::lastFailure<FailureT>();
+            detail::invalidateLastFailure();
+            fill(ValueStorage(std::in_place_index<2>, std::move(failure)));
+            return;
+        }
+        fill(ValueStorage(std::in_place_index<1>, std::move(result)));
+    }
+
+    void success(const T &result) noexcept
+    {
+        T copy = result;
+        success(std::move(copy));
+    }
+
+    void failure(FailureT &&reason) noexcept { fill(ValueStorage(std::in_place_index<2>, std::move(reason))); }
+
+    void failure(const FailureT &reason) noexcept
+    {
+        FailureT copy = reason;
+        failure(std::move(copy));
+    }
+
+private:
+    void fill(ValueStorage &&value) noexcept
+    {
+        if (m_filled || !d)
+            return;
+        m_filled = true;
+        d->fill(std::move(value));
+    }
+
+    template <typename Other>
+    void fillFrom(Other &&other)
+    {
+        if constexpr (detail::IsUniqueFuture_V<Other>) {
+            assert(other.d);
+            // Target is captured separately from promise to keep promise usable if continuation hand off fails
+            auto data = std::move(other.d);
+            data->setContinuation([target = d](ValueStorage &&value) noexcept { target->fill(std::move(value)); });
+            m_filled = true;
+        } else {
+            Future<T, FailureT> shared(std::forward<Other>(other));
+            shared.addContinuation([target = d](const ValueStorage &value) noexcept {
+                target->fill(ValueStorage(value));
+            });
+            m_filled = true;
+        }
+    }
+
+    detail::IntrusivePtr<Data> d;
+    bool m_futureTaken = false;
+    bool m_filled = false;
+};
+} // namespace asynqro
+
+#endif // ASYNQRO_UNIQUEFUTURE_H
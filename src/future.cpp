@@ -27,6 +27,8 @@
 namespace asynqro {
 namespace detail {
 static std::atomic_int_fast64_t counter{0};
+static std::atomic_int32_t depthLimit{128};
+static thread_local ContinuationsTrampoline trampoline;
 
 void incrementFuturesUsage()
 {
@@ -38,10 +40,36 @@ void decrementFuturesUsage()
     counter.fetch_sub(1, std::memory_order_relaxed);
 }
 
+ContinuationsTrampoline &currentContinuationsTrampoline() noexcept
+{
+    return trampoline;
+}
+
+int32_t currentContinuationsDepthLimit() noexcept
+{
+    return depthLimit.load(std::memory_order_relaxed);
+}
+
+WatchedFuturesEpoch &watchedFuturesEpoch() noexcept
+{
+    static WatchedFuturesEpoch epoch;
+    return epoch;
+}
+
 } // namespace detail
 
 int_fast64_t instantFuturesUsage()
 {
     return detail::counter.load(std::memory_order_relaxed);
 }
+
+void setContinuationsDepthLimit(int32_t limit)
+{
+    detail::depthLimit.store(std::max(1, limit), std::memory_order_relaxed);
+}
+
+int32_t continuationsDepthLimit()
+{
+    return detail::depthLimit.load(std::memory_order_relaxed);
+}
 } // namespace asynqro
@@ -0,0 +1,147 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include "asynqro/impl/memorypool.h"
+
+#include <atomic>
+#include <new>
+
+namespace asynqro {
+namespace detail {
+namespace {
+constexpr size_t SIZE_CLASS_STEP = 64;
+constexpr size_t SIZE_CLASSES_AMOUNT = 16;
+constexpr size_t MAX_POOLED_SIZE = SIZE_CLASS_STEP * SIZE_CLASSES_AMOUNT;
+constexpr size_t MAX_POOLED_BYTES_PER_CLASS = 256 * 1024;
+
+std::atomic_int_fast64_t pooledAllocations{0};
+std::atomic_int_fast64_t nonPooledAllocations{0};
+
+struct FreeNode
+{
+    FreeNode *next;
+};
+
+struct ThreadPool
+{
+    ThreadPool() = default;
+    ThreadPool(const ThreadPool &) = delete;
+    ThreadPool(ThreadPool &&) = delete;
+    ThreadPool &operator=(const ThreadPool &) = delete;
+    ThreadPool &operator=(ThreadPool &&) = delete;
+    ~ThreadPool();
+
+    FreeNode *heads[SIZE_CLASSES_AMOUNT] = {};
+    size_t cachedAmounts[SIZE_CLASSES_AMOUNT] = {};
+};
+
+// Trivially destructible, so it is still valid when pool itself is already destroyed on thread exit
+thread_local bool threadPoolDestroyed = false;
+thread_local ThreadPool threadPool;
+
+ThreadPool::~ThreadPool()
+{
+    threadPoolDestroyed = true;
+    for (FreeNode *head : heads) {
+        while (head) {
+            FreeNode *next = head->next;
+            ::operator delete(head);
+            head = next;
+        }
+    }
+}
+
+constexpr size_t sizeClass(size_t size)
+{
+    return (size - 1) / SIZE_CLASS_STEP;
+}
+
+inline void *allocate(size_t size, bool *pooled)
+{
+    *pooled = false;
+    if (size == 0)
+        size = 1;
+    if (size > MAX_POOLED_SIZE)
+        return ::operator new(size);
+    const size_t index = sizeClass(size);
+    if (!threadPoolDestroyed) {
+        ThreadPool &pool = threadPool;
+        FreeNode *head = pool.heads[index];
+        if (head) {
+            pool.heads[index] = head->next;
+            --pool.cachedAmounts[index];
+            *pooled = true;
+            return head;
+        }
+    }
+    // Always allocating whole size class to allow reuse by any object of this class
+    return ::operator new((index + 1) * SIZE_CLASS_STEP);
+}
+} // namespace
+
+void *allocateFromPool(size_t size)
+{
+    bool pooled = false;
+    return allocate(size, &pooled);
+}
+
+void deallocateToPool(void *ptr, size_t size) noexcept
+{
+    if (!ptr)
+        return;
+    if (size == 0)
+        size = 1;
+    if (size <= MAX_POOLED_SIZE && !threadPoolDestroyed) {
+        const size_t index = sizeClass(size);
+        ThreadPool &pool = threadPool;
+        if (pool.cachedAmounts[index] * (index + 1) * SIZE_CLASS_STEP < MAX_POOLED_BYTES_PER_CLASS) {
+            auto node = static_cast<FreeNode *>(ptr);
+            node->next = pool.heads[index];
+            pool.heads[index] = node;
+            ++pool.cachedAmounts[index];
+            return;
+        }
+    }
+    ::operator delete(ptr);
+}
+
+void *allocateFromPoolCounted(size_t size)
+{
+    bool pooled = false;
+    void *result = allocate(size, &pooled);
+    (pooled ? pooledAllocations : nonPooledAllocations).fetch_add(1, std::memory_order_relaxed);
+    return result;
+}
+} // namespace detail
+
+int_fast64_t instantPooledAllocations()
+{
+    return detail::pooledAllocations.load(std::memory_order_relaxed);
+}
+
+int_fast64_t instantNonPooledAllocations()
+{
+    return detail::nonPooledAllocations.load(std::memory_order_relaxed);
+}
+} // namespace asynqro
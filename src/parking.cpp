@@ -0,0 +1,119 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include "asynqro/impl/parking.h"
+
+#ifdef __linux__
+#    include <linux/futex.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+
+#    include <climits>
+#    include <ctime>
+#else
+#    include <condition_variable>
+#    include <cstdint>
+#    include <mutex>
+#endif
+
+namespace asynqro::detail {
+#ifdef __linux__
+static_assert(sizeof(std::atomic_int) == sizeof(int) && std::atomic_int::is_always_lock_free,
+              "Futex requires std::atomic_int to be a plain int");
+
+void parkWhileEqual(std::atomic_int *address, int expected, std::chrono::nanoseconds timeout) noexcept
+{
+    if (address->load(std::memory_order_acquire) != expected)
+        return;
+    timespec relative = {};
+    timespec *relativePtr = nullptr;
+    if (timeout.count() > 0) {
+        auto seconds = std::chrono::duration_cast<std::chrono::seconds>(timeout);
+        relative.tv_sec = static_cast<time_t>(seconds.count());
+        relative.tv_nsec = static_cast<long>((timeout - seconds).count());
+        relativePtr = &relative;
+    }
+    // EINTR, EAGAIN and ETIMEDOUT are all fine here, caller rechecks condition anyway
+    syscall(SYS_futex, reinterpret_cast<int *>(address), FUTEX_WAIT_PRIVATE, expected, relativePtr, nullptr, 0);
+}
+
+void unparkAll(std::atomic_int *address) noexcept
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(address), FUTEX_WAKE_PRIVATE, INT_MAX, nullptr, nullptr, 0);
+}
+
+void unparkOne(std::atomic_int *address) noexcept
+{
+    syscall(SYS_futex, reinterpret_cast<int *>(address), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+}
+#else
+namespace {
+// Parking lot fallback. Addresses are distributed among fixed amount of buckets, collisions only lead to
+// extra wakeups that are filtered out by callers.
+constexpr size_t BUCKETS_AMOUNT = 64;
+
+struct alignas(64) ParkingBucket
+{
+    std::mutex mutex;
+    std::condition_variable waiter;
+};
+
+ParkingBucket &bucketFor(const void *address)
+{
+    static ParkingBucket buckets[BUCKETS_AMOUNT];
+    auto hash = reinterpret_cast<uintptr_t>(address);
+    hash ^= hash >> 17;
+    return buckets[(hash >> 4) % BUCKETS_AMOUNT];
+}
+} // namespace
+
+void parkWhileEqual(std::atomic_int *address, int expected, std::chrono::nanoseconds timeout) noexcept
+{
+    ParkingBucket &bucket = bucketFor(address);
+    std::unique_lock lock(bucket.mutex);
+    // Checking under lock guarantees that unpark after value change will not be missed
+    if (address->load(std::memory_order_acquire) != expected)
+        return;
+    if (timeout.count() > 0)
+        bucket.waiter.wait_for(lock, timeout);
+    else
+        bucket.waiter.wait(lock);
+}
+
+void unparkAll(std::atomic_int *address) noexcept
+{
+    ParkingBucket &bucket = bucketFor(address);
+    {
+        std::lock_guard lock(bucket.mutex);
+    }
+    bucket.waiter.notify_all();
+}
+
+void unparkOne(std::atomic_int *address) noexcept
+{
+    // Bucket can be shared with other addresses, so waking only one thread could wake wrong one
+    unparkAll(address);
+}
+#endif
+} // namespace asynqro::detail
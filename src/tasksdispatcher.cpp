@@ -25,18 +25,21 @@
 #include "asynqro/impl/tasksdispatcher.h"
 
 #include "asynqro/impl/containers_traverse.h"
+#include "asynqro/impl/dynamicbitset_p.h"
+#include "asynqro/impl/eventcount_p.h"
+#include "asynqro/impl/shardedcounter_p.h"
 #include "asynqro/impl/spinlock.h"
 #include "asynqro/impl/taskslist_p.h"
+#include "asynqro/impl/workstealingdeque_p.h"
 #include "asynqro/tasks.h"
 
 #include <algorithm>
-#include <bitset>
+#include <array>
 #include <chrono>
-#include <condition_variable>
 #include <deque>
 #include <limits>
 #include <map>
-#include <mutex>
+#include <memory>
 #include <optional>
 #include <set>
 #include <thread>
@@ -45,7 +48,8 @@
 #include <vector>
 
 namespace asynqro::tasks {
-static constexpr int32_t MAX_ALLOWED_CAPACITY = 512;
+// Limit is big enough to keep 16 threads per core even on big multi-socket machines
+static const int32_t MAX_ALLOWED_CAPACITY = std::max<int32_t>(512, std::thread::hardware_concurrency() * 16);
 
 static const int32_t INTENSIVE_CAPACITY = std::clamp<int32_t>(std::thread::hardware_concurrency(), 1,
                                                               MAX_ALLOWED_CAPACITY);
@@ -53,80 +57,121 @@ static const int32_t DEFAULT_CUSTOM_CAPACITY = INTENSIVE_CAPACITY;
 static const int32_t DEFAULT_TOTAL_CAPACITY = std::clamp(INTENSIVE_CAPACITY * 8, 64, MAX_ALLOWED_CAPACITY);
 static const int32_t DEFAULT_BOUND_CAPACITY = DEFAULT_TOTAL_CAPACITY / 4;
 
-static constexpr uint64_t INTENSIVE_SUBPOOL = packPoolInfo(TaskType::Intensive, 0);
+static constexpr uint64_t NO_SUBPOOL = std::numeric_limits<uint64_t>::max();
 
-template <size_t N>
-int32_t firstSetBit(const std::bitset<N> &bitset, int32_t left = 0, int32_t right = N) noexcept
-{
-    for (int32_t i = left; i < right; ++i) {
-        if (bitset[i])
-            return i;
-    }
-    return -1;
-}
+// Max amount of injected tasks worker moves to its own deque at once
+static constexpr size_t MAX_INJECTED_BATCH = 32;
+
+// Amount of cpu pauses in each idle loop before worker parks
+static constexpr int IDLE_LOOP_PAUSES = 16;
 
-template <size_t N>
-int32_t firstSetBit(const std::bitset<N> &bitset, const std::bitset<N> &exclude, int32_t left = 0,
-                    int32_t right = N) noexcept
+// Subpool of task that is currently run by this thread, NO_SUBPOOL if it is not a worker or it is idle
+static thread_local uint64_t currentSubPool = NO_SUBPOOL;
+
+class Worker;
+// Worker that runs in this thread, nullptr for all non-worker threads
+static thread_local Worker *currentWorker = nullptr;
+
+// Tasks that can be handled by work stealing are split in two lanes, because only intensive ones have capacity limit
+enum StealableLane : uint8_t
 {
-    for (int32_t i = left; i < right; ++i) {
-        if (bitset[i] && !exclude[i])
-            return i;
-    }
-    return -1;
-}
+    IntensiveLane = 0,
+    CustomLane = 1,
+    StealableLanesCount
+};
 
-template <size_t N>
-int32_t lastSetBit(const std::bitset<N> &bitset, const std::bitset<N> &exclude, int32_t left = 0, int32_t right = N) noexcept
+constexpr StealableLane stealableLane(TaskType type) noexcept
 {
-    for (int32_t i = right - 1; i >= left; --i) {
-        if (bitset[i] && !exclude[i])
-            return i;
-    }
-    return -1;
+    return type == TaskType::Intensive ? IntensiveLane : CustomLane;
 }
 
-class Worker;
 class TasksDispatcherPrivate
 {
     friend class TasksDispatcher;
+    friend class Worker;
 
 public:
     void taskFinished(int32_t workerId, const TaskInfo &task, bool askingForNext);
 
+    bool isStealable(TaskType type, int32_t tag, TaskPriority priority) const noexcept;
+    // Moves task out only if it was successfully inserted
+    bool insertStealableTask(TaskInfo &task) noexcept;
+    // Returns amount of tasks inserted from the beginning of wrappedTasks, other ones are left untouched
+    size_t insertStealableTasks(std::vector<detail::TaskFunction> &wrappedTasks, TaskType type, int32_t tag) noexcept;
+    TaskInfo *takeStealableTask(Worker *worker) noexcept;
+    void stealableTaskFinished(Worker *worker, TaskType type) noexcept;
+    bool hasRunnableStealableTasks() const noexcept;
+    bool canSteal(const Worker *worker) const noexcept;
+    void registerIdleStealer(const Worker *worker) noexcept;
+    void unregisterIdleStealer(int32_t workerId) noexcept;
+    void wakeIdleStealerIfNeeded() noexcept;
+
 private:
+    struct StealableTasks
+    {
+        detail::SpinLock injectedLock;
+        std::deque<TaskInfo *> injected; // Tasks that are not yet in any worker deque
+        std::atomic_int_fast32_t pending{0}; // Both injected and in workers deques
+    };
+
+    bool tryAcquireIntensiveSlot() noexcept;
+    void releaseIntensiveSlot() noexcept;
+    TaskInfo *takeInjectedTasks(Worker *worker, StealableLane lane) noexcept;
+    TaskInfo *stealFromPeers(Worker *worker, StealableLane lane) noexcept;
+    // Returns false if there is no need in more workers or nobody can be woken
+    bool wakeIdleStealer(StealableLane lane) noexcept;
+
     void schedule(int32_t workerId = -1) noexcept;
+    // Same as above, but with mainLock already acquired. Lock is released before task is passed to worker
+    void schedule(detail::SpinLockHolder &lock, int32_t workerId) noexcept;
+    // Passes up to maxTasks non-bound tasks to different available workers in one pass. Lock is released after that
+    void scheduleMany(detail::SpinLockHolder &lock, int32_t maxTasks) noexcept;
     // All private methods below should always be called under mainLock
     bool createNewWorkerIfPossible() noexcept;
     bool scheduleSingleTask(const TaskInfo &task, int32_t workerId) noexcept;
 
     int32_t customTagCapacity(int32_t tag) const;
     bool isCustomTagPaused(int32_t tag) const;
+    // Should be called each time capacity, usage or pause state of custom subpool is changed
+    void updateCustomSubPoolAvailability(int32_t tag) noexcept;
 
     std::map<uint64_t, int32_t> subPoolsUsage; // pool info -> amount
     std::unordered_map<int32_t, int32_t> customTagCapacities; // tag -> capacity
     std::unordered_set<int32_t> pausedCustomTags;
 
-    TasksList tasksQueue; // All except bound ones to known workers
+    TasksQueue tasksQueue; // All except bound ones to known workers
 
     std::vector<Worker *> allWorkers;
-    //TODO: replace with dynamic bitset implementation
-    std::bitset<MAX_ALLOWED_CAPACITY> availableWorkers; // Indices in allWorkers vector, including bound
+    detail::DynamicBitset availableWorkers; // Indices in allWorkers vector, including bound
 
-    std::bitset<MAX_ALLOWED_CAPACITY> boundWorkers; // Indices in allWorkers vector of workers who are bound to at least one tag
+    detail::DynamicBitset boundWorkers; // Indices in allWorkers vector of workers who are bound to at least one tag
 
     std::unordered_map<int32_t, int32_t> tagToWorkerBindings; // tag -> index in allWorkers vector
     std::unordered_map<int32_t, int> workersBindingsCount; // Index in allWorkers vector -> amount of tags bound
 
     TasksDispatcher *q_ptr = nullptr;
 
-    int32_t capacity = DEFAULT_TOTAL_CAPACITY;
+    std::atomic_int32_t capacity{DEFAULT_TOTAL_CAPACITY}; // Changed only under mainLock
     int32_t boundCapacity = DEFAULT_BOUND_CAPACITY;
     detail::SpinLock mainLock;
     std::atomic_bool poisoningStarted{false};
 
+    std::atomic_int_fast32_t intensiveUsage{0}; // Shared by both scheduling modes, so it is kept outside of mainLock
+    std::atomic_int_fast32_t queuedIntensiveTasks{0}; // Intensive tasks in tasksQueue
+
+    std::atomic_bool workStealingEnabled{false};
+    std::array<StealableTasks, StealableLanesCount> stealableTasks;
+    // Workers are only added while dispatcher is alive, so thieves can traverse them without mainLock
+    std::unique_ptr<std::atomic<Worker *>[]> stealers{new std::atomic<Worker *>[MAX_ALLOWED_CAPACITY]()};
+    std::atomic_int32_t stealersCount{0};
+    std::atomic_int32_t searchingStealers{0}; // Non-bound workers that are looking for tasks but are not parked
+    detail::SpinLock idleStealersLock;
+    std::vector<int32_t> idleStealers;
+    std::vector<int32_t> idleBoundStealers; // Used only if there are no non-bound workers to wake
+    std::atomic_int32_t idleStealersCount{0}; // Non-bound only
+
 public:
-    std::atomic_int_fast32_t instantUsage{0};
+    detail::ShardedCounter instantUsage;
     std::atomic_int_fast32_t idleLoopsAmount{1024};
 };
 
@@ -143,20 +188,34 @@ public:
     void start();
 
     void addTask(TaskInfo &&task) noexcept;
+    void addTasks(std::vector<detail::TaskFunction> &&wrappedTasks, TaskType type, int32_t tag,
+                  TaskPriority priority) noexcept;
+    void wakeUp() noexcept;
     void poisonPill();
+    void join();
+
+    int32_t workerId() const noexcept { return id; }
+    bool isBound() const noexcept { return bound.load(std::memory_order_relaxed); }
+    void markAsBound() noexcept { bound.store(true, std::memory_order_relaxed); }
+#ifdef ASYNQRO_SPINLOCK_STATS
+    detail::SpinLockStats tasksLockStats() const noexcept { return tasksLock.stats(); }
+#endif
+
+    std::array<detail::WorkStealingDeque<TaskInfo>, StealableLanesCount> localTasks;
 
 protected:
     void run();
 
 private:
-    std::mutex waitingLock;
-    std::condition_variable waiter;
+    detail::EventCount events;
     std::deque<TaskInfo> workerTasks;
+    std::atomic_int32_t workerTasksCount{0}; // Lets worker check its queue without tasksLock
     int32_t id = 0;
     int_fast32_t idleLoopsAmount = 0;
     std::thread myself;
 
     std::atomic_bool poisoned{false};
+    std::atomic_bool bound{false};
     detail::SpinLock tasksLock;
 };
 
@@ -164,16 +223,27 @@ TasksDispatcher::TasksDispatcher() : d_ptr(new TasksDispatcherPrivate)
 {
     d_ptr->q_ptr = this; // lgtm [cpp/stack-address-escape]
     d_ptr->allWorkers.reserve(static_cast<size_t>(capacity()));
-    d_ptr->customTagCapacities[0] = d_ptr->capacity;
+    d_ptr->customTagCapacities[0] = d_ptr->capacity.load(std::memory_order_relaxed);
 }
 
 TasksDispatcher::~TasksDispatcher()
 {
     d_ptr->poisoningStarted.store(true, std::memory_order_relaxed);
     detail::SpinLockHolder lock(&d_ptr->mainLock);
+    // Workers can steal from each other, so none of them can be destroyed before all are stopped
+    for (auto worker : d_ptr->allWorkers)
+        worker->poisonPill();
+    for (auto worker : d_ptr->allWorkers)
+        worker->join();
+    d_ptr->stealersCount.store(0, std::memory_order_relaxed);
     for (auto worker : d_ptr->allWorkers)
         delete worker;
     d_ptr->allWorkers.clear();
+    for (auto &lane : d_ptr->stealableTasks) {
+        for (TaskInfo *task : lane.injected)
+            delete task;
+        lane.injected.clear();
+    }
 }
 
 TasksDispatcher *TasksDispatcher::instance() noexcept
@@ -184,7 +254,7 @@ TasksDispatcher *TasksDispatcher::instance() noexcept
 
 int32_t TasksDispatcher::capacity() const
 {
-    return d_ptr->capacity;
+    return d_ptr->capacity.load(std::memory_order_relaxed);
 }
 
 int32_t TasksDispatcher::subPoolCapacity(TaskType type, int32_t tag) const
@@ -207,21 +277,27 @@ void TasksDispatcher::setCapacity(int32_t capacity)
     capacity = std::max(INTENSIVE_CAPACITY, capacity);
     capacity = std::max(static_cast<int32_t>(d_ptr->allWorkers.size()), capacity);
     capacity = std::min(capacity, MAX_ALLOWED_CAPACITY);
-    d_ptr->capacity = capacity;
+    d_ptr->capacity.store(capacity, std::memory_order_relaxed);
     d_ptr->allWorkers.reserve(static_cast<size_t>(capacity));
     d_ptr->customTagCapacities[0] = capacity;
     d_ptr->boundCapacity = std::min(d_ptr->boundCapacity, capacity);
+    d_ptr->updateCustomSubPoolAvailability(0);
+    lock.unlock();
+    d_ptr->schedule();
 }
 
 void TasksDispatcher::addCustomTag(int32_t tag, int32_t capacity)
 {
     if (tag <= 0)
         return;
-    capacity = std::clamp(capacity, 1, d_ptr->capacity);
+    capacity = std::clamp(capacity, 1, d_ptr->capacity.load(std::memory_order_relaxed));
     detail::SpinLockHolder lock(&d_ptr->mainLock, d_ptr->poisoningStarted);
     if (!lock.isLocked())
         return;
     d_ptr->customTagCapacities[tag] = capacity;
+    d_ptr->updateCustomSubPoolAvailability(tag);
+    lock.unlock();
+    d_ptr->schedule();
 }
 
 void TasksDispatcher::setBoundCapacity(int32_t capacity)
@@ -240,6 +316,7 @@ void TasksDispatcher::pauseCustomTag(int32_t tag)
     if (!lock.isLocked())
         return;
     d_ptr->pausedCustomTags.insert(tag);
+    d_ptr->updateCustomSubPoolAvailability(tag);
 }
 
 void TasksDispatcher::resumeCustomTag(int32_t tag)
@@ -250,6 +327,7 @@ void TasksDispatcher::resumeCustomTag(int32_t tag)
     if (!lock.isLocked())
         return;
     d_ptr->pausedCustomTags.erase(tag);
+    d_ptr->updateCustomSubPoolAvailability(tag);
     lock.unlock();
     d_ptr->schedule();
 }
@@ -266,7 +344,18 @@ void TasksDispatcher::setIdleLoopsAmount(int_fast32_t amount)
 
 int_fast32_t TasksDispatcher::instantUsage() const
 {
-    return d_ptr->instantUsage.load(std::memory_order_relaxed);
+    return d_ptr->instantUsage.load();
+}
+
+bool TasksDispatcher::workStealingEnabled() const
+{
+    return d_ptr->workStealingEnabled.load(std::memory_order_relaxed);
+}
+
+void TasksDispatcher::setWorkStealingEnabled(bool enabled)
+{
+    // Tasks that are already in workers deques will be processed regardless of this flag
+    d_ptr->workStealingEnabled.store(enabled, std::memory_order_relaxed);
 }
 
 void TasksDispatcher::preHeatPool(double amount)
@@ -288,12 +377,32 @@ void TasksDispatcher::preHeatIntensivePool()
         d_ptr->createNewWorkerIfPossible();
 }
 
-void TasksDispatcher::insertTaskInfo(std::function<void()> &&wrappedTask, TaskType type, int32_t tag,
+#ifdef ASYNQRO_SPINLOCK_STATS
+detail::SpinLockStats TasksDispatcher::mainLockStats() const
+{
+    return d_ptr->mainLock.stats();
+}
+
+detail::SpinLockStats TasksDispatcher::workersLockStats() const
+{
+    detail::SpinLockStats result;
+    detail::SpinLockHolder lock(&d_ptr->mainLock, d_ptr->poisoningStarted);
+    if (!lock.isLocked())
+        return result;
+    for (auto worker : d_ptr->allWorkers)
+        result += worker->tasksLockStats();
+    return result;
+}
+#endif
+
+void TasksDispatcher::insertTaskInfo(detail::TaskFunction &&wrappedTask, TaskType type, int32_t tag,
                                      TaskPriority priority) noexcept
 {
     // We consider all intensive tasks as under single tag
     tag = type == TaskType::Intensive ? 0 : std::max(0, tag);
     TaskInfo taskInfo = TaskInfo(std::move(wrappedTask), type, tag, priority);
+    if (d_ptr->isStealable(type, tag, priority) && d_ptr->insertStealableTask(taskInfo))
+        return;
     detail::SpinLockHolder lock(&d_ptr->mainLock, d_ptr->poisoningStarted);
     if (!lock.isLocked())
         return;
@@ -301,13 +410,13 @@ void TasksDispatcher::insertTaskInfo(std::function<void()> &&wrappedTask, TaskTy
     if (type == TaskType::ThreadBound) {
         auto boundWorker = d_ptr->tagToWorkerBindings.find(tag);
         if (boundWorker != d_ptr->tagToWorkerBindings.cend()) {
-            d_ptr->availableWorkers[boundWorker->second] = false;
+            d_ptr->availableWorkers.reset(boundWorker->second);
             lock.unlock();
             d_ptr->allWorkers[static_cast<size_t>(boundWorker->second)]->addTask(std::move(taskInfo));
             return;
         }
     } else if (d_ptr->availableWorkers.any() && d_ptr->tasksQueue.empty()) {
-        int32_t workerId = lastSetBit(d_ptr->availableWorkers, d_ptr->boundWorkers, 0, d_ptr->allWorkers.size());
+        int32_t workerId = d_ptr->availableWorkers.lastSetBit(d_ptr->boundWorkers, 0, d_ptr->allWorkers.size());
         if (d_ptr->scheduleSingleTask(taskInfo, workerId)) {
             lock.unlock();
             d_ptr->allWorkers[static_cast<size_t>(workerId)]->addTask(std::move(taskInfo));
@@ -324,21 +433,97 @@ void TasksDispatcher::insertTaskInfo(std::function<void()> &&wrappedTask, TaskTy
         }
         return;
     }
+    if (type == TaskType::Intensive)
+        d_ptr->queuedIntensiveTasks.fetch_add(1, std::memory_order_relaxed);
     if (d_ptr->availableWorkers.any() || static_cast<int32_t>(d_ptr->allWorkers.size()) < capacity()) {
-        if (type == TaskType::Intensive && d_ptr->subPoolsUsage[INTENSIVE_SUBPOOL] >= INTENSIVE_CAPACITY)
+        if (type == TaskType::Intensive
+            && d_ptr->intensiveUsage.load(std::memory_order_relaxed) >= INTENSIVE_CAPACITY) {
             return;
+        }
 
         lock.unlock();
         d_ptr->schedule();
     }
 }
 
+void TasksDispatcher::insertTaskInfos(std::vector<detail::TaskFunction> &&wrappedTasks, TaskType type, int32_t tag,
+                                      TaskPriority priority) noexcept
+{
+    if (wrappedTasks.empty())
+        return;
+    // Same normalization as in insertTaskInfo
+    tag = type == TaskType::Intensive ? 0 : std::max(0, tag);
+    size_t firstNotQueued = 0;
+    if (d_ptr->isStealable(type, tag, priority))
+        firstNotQueued = d_ptr->insertStealableTasks(wrappedTasks, type, tag);
+    if (firstNotQueued == wrappedTasks.size())
+        return;
+
+    detail::SpinLockHolder lock(&d_ptr->mainLock, d_ptr->poisoningStarted);
+    if (!lock.isLocked())
+        return;
+    if (type == TaskType::ThreadBound) {
+        auto boundWorker = d_ptr->tagToWorkerBindings.find(tag);
+        if (boundWorker != d_ptr->tagToWorkerBindings.cend()) {
+            d_ptr->availableWorkers.reset(boundWorker->second);
+            lock.unlock();
+            d_ptr->allWorkers[static_cast<size_t>(boundWorker->second)]->addTasks(std::move(wrappedTasks), type, tag,
+                                                                                 priority);
+            return;
+        }
+    }
+
+    int32_t queuedAmount = 0;
+    for (; firstNotQueued < wrappedTasks.size(); ++firstNotQueued) {
+        TaskInfo taskInfo(std::move(wrappedTasks[firstNotQueued]), type, tag, priority);
+        try {
+            d_ptr->tasksQueue.insert(std::move(taskInfo));
+        } catch (...) {
+            wrappedTasks[firstNotQueued] = std::move(taskInfo.task);
+            break;
+        }
+        ++queuedAmount;
+    }
+    if (type == TaskType::Intensive)
+        d_ptr->queuedIntensiveTasks.fetch_add(queuedAmount, std::memory_order_relaxed);
+    if (type == TaskType::ThreadBound)
+        d_ptr->schedule(lock, -1);
+    else
+        d_ptr->scheduleMany(lock, queuedAmount);
+    lock.unlock();
+
+    // Tasks that failed to be queued are run right away, same as in insertTaskInfo
+    for (; firstNotQueued < wrappedTasks.size(); ++firstNotQueued) {
+        if (wrappedTasks[firstNotQueued])
+            wrappedTasks[firstNotQueued]();
+    }
+}
+
+void detail::postContinuation(TaskFunction &&f, TaskType type, int32_t tag, TaskPriority priority) noexcept
+{
+    TasksDispatcher::instance()->insertTaskInfo(std::move(f), type, tag, priority);
+}
+
+bool detail::isCurrentWorkerInSubPool(TaskType type, int32_t tag) noexcept
+{
+    if (currentSubPool == NO_SUBPOOL)
+        return false;
+    // Same normalization as in insertTaskInfo
+    tag = type == TaskType::Intensive ? 0 : tag;
+    return currentSubPool == packPoolInfo(type, tag);
+}
+
 void TasksDispatcherPrivate::taskFinished(int32_t workerId, const TaskInfo &task, bool askingForNext)
 {
+    if (task.type == TaskType::Intensive)
+        releaseIntensiveSlot();
+    // Only custom subpools usage is kept under mainLock, so worker that still has tasks has nothing to report
+    if (task.type != TaskType::Custom && !askingForNext)
+        return;
     detail::SpinLockHolder lock(&mainLock, poisoningStarted);
     if (!lock.isLocked())
         return;
-    if (task.type != TaskType::ThreadBound) {
+    if (task.type == TaskType::Custom) {
         uint64_t poolInfo = packPoolInfo(task);
         if (--subPoolsUsage[poolInfo] <= 0) {
             if (task.tag)
@@ -346,35 +531,40 @@ void TasksDispatcherPrivate::taskFinished(int32_t workerId, const TaskInfo &task
             else
                 subPoolsUsage[poolInfo] = 0;
         }
+        updateCustomSubPoolAvailability(task.tag);
     }
     if (askingForNext) {
-        availableWorkers[workerId] = true;
-        lock.unlock();
-        schedule(workerId);
+        availableWorkers.set(workerId);
+        schedule(lock, workerId);
     }
 }
 
 void TasksDispatcherPrivate::schedule(int32_t workerId) noexcept
 {
     detail::SpinLockHolder lock(&mainLock, poisoningStarted);
-    if (!lock.isLocked())
-        return;
+    if (lock.isLocked())
+        schedule(lock, workerId);
+}
+
+void TasksDispatcherPrivate::schedule(detail::SpinLockHolder &lock, int32_t workerId) noexcept
+{
     if (tasksQueue.empty())
         return;
     if (availableWorkers.none() && !createNewWorkerIfPossible())
         return;
 
-    workerId = (workerId < 0 || !availableWorkers[workerId])
-                   ? lastSetBit(availableWorkers, boundWorkers, 0, allWorkers.size())
+    workerId = (workerId < 0 || !availableWorkers.test(workerId))
+                   ? availableWorkers.lastSetBit(boundWorkers, 0, allWorkers.size())
                    : workerId;
 
     if (workerId == -1)
-        workerId = firstSetBit(availableWorkers, 0, allWorkers.size());
+        workerId = availableWorkers.firstSetBit(0, allWorkers.size());
 
     int32_t boundWorkerId = -1;
     bool newBoundTask = false;
-    for (auto it = tasksQueue.begin(); it != tasksQueue.end();) {
-        TaskInfo &task = *it;
+    // Only first task of each subpool is checked, other tasks of the same subpool can't be scheduled if it can't
+    for (auto ready = tasksQueue.firstReady(); ready; ready = tasksQueue.nextReady(*ready)) {
+        TaskInfo &task = tasksQueue.front(ready->poolInfo);
         // We need to check again for tag binding, it could happen while task was in queue
         if (task.type == TaskType::ThreadBound) {
             // We need to evenly distibute bindings across all workers
@@ -385,14 +575,14 @@ void TasksDispatcherPrivate::schedule(int32_t workerId) noexcept
             } else if (static_cast<int32_t>(workersBindingsCount.size()) < boundCapacity) {
                 newBoundTask = true;
                 // We discard workerId here, because it is taken from the end of the list and we are trying to keep bound at the beginning
-                boundWorkerId = firstSetBit(availableWorkers, boundWorkers, 0, allWorkers.size());
+                boundWorkerId = availableWorkers.firstSetBit(boundWorkers, 0, allWorkers.size());
                 if (boundWorkerId < 0 && createNewWorkerIfPossible())
                     boundWorkerId = static_cast<int32_t>(allWorkers.size()) - 1;
             } else {
                 newBoundTask = true;
                 int foundMin = std::numeric_limits<int>::max();
-                for (int32_t found = firstSetBit(boundWorkers, 0, allWorkers.size()); found != -1;
-                     found = firstSetBit(boundWorkers, found + 1, allWorkers.size())) {
+                for (int32_t found = boundWorkers.firstSetBit(0, allWorkers.size()); found != -1;
+                     found = boundWorkers.firstSetBit(found + 1, allWorkers.size())) {
                     auto bindingIt = workersBindingsCount.find(found);
                     if (bindingIt != workersBindingsCount.end() && bindingIt->second < foundMin) {
                         boundWorkerId = found;
@@ -402,36 +592,77 @@ void TasksDispatcherPrivate::schedule(int32_t workerId) noexcept
             }
             if (boundWorkerId >= 0) {
                 if (newBoundTask) {
-                    boundWorkers[boundWorkerId] = true;
+                    allWorkers[static_cast<size_t>(boundWorkerId)]->markAsBound();
+                    unregisterIdleStealer(boundWorkerId);
+                    boundWorkers.set(boundWorkerId);
                     ++workersBindingsCount[boundWorkerId];
                     tagToWorkerBindings[task.tag] = boundWorkerId;
                 }
-                availableWorkers[boundWorkerId] = false;
-                allWorkers[static_cast<size_t>(boundWorkerId)]->addTask(std::move(task));
-                it = tasksQueue.erase(it);
+                availableWorkers.reset(boundWorkerId);
+                allWorkers[static_cast<size_t>(boundWorkerId)]->addTask(tasksQueue.takeFront(ready->poolInfo));
                 if (boundWorkerId == workerId)
                     break;
                 continue;
             }
         } /* not threadbound */ else if (scheduleSingleTask(task, workerId)) {
-            if (boundWorkers[workerId] && createNewWorkerIfPossible())
+            if (boundWorkers.test(workerId) && createNewWorkerIfPossible())
                 workerId = allWorkers.size() - 1;
-            TaskInfo selectedTask = std::move(task);
-            tasksQueue.erase(it);
+            TaskInfo selectedTask = tasksQueue.takeFront(ready->poolInfo);
+            if (selectedTask.type == TaskType::Intensive)
+                queuedIntensiveTasks.fetch_sub(1, std::memory_order_relaxed);
             lock.unlock();
             allWorkers[static_cast<size_t>(workerId)]->addTask(std::move(selectedTask));
             break;
         }
-        ++it;
     }
 }
 
+void TasksDispatcherPrivate::scheduleMany(detail::SpinLockHolder &lock, int32_t maxTasks) noexcept
+{
+    std::vector<std::pair<Worker *, TaskInfo>> selectedTasks;
+    try {
+        selectedTasks.reserve(static_cast<size_t>(std::clamp(maxTasks, 0, capacity.load(std::memory_order_relaxed))));
+    } catch (...) {
+    }
+    while (selectedTasks.size() < selectedTasks.capacity() && !tasksQueue.empty()) {
+        if (availableWorkers.none() && !createNewWorkerIfPossible())
+            break;
+        int32_t workerId = availableWorkers.lastSetBit(boundWorkers, 0, allWorkers.size());
+        if (workerId == -1) {
+            workerId = createNewWorkerIfPossible() ? static_cast<int32_t>(allWorkers.size()) - 1
+                                                   : availableWorkers.firstSetBit(0, allWorkers.size());
+        }
+        bool taskSelected = false;
+        for (auto ready = tasksQueue.firstReady(); ready; ready = tasksQueue.nextReady(*ready)) {
+            // Thread bound tasks need bindings logic, they are left for regular schedule() calls
+            if (tasksQueue.front(ready->poolInfo).type == TaskType::ThreadBound
+                || !scheduleSingleTask(tasksQueue.front(ready->poolInfo), workerId)) {
+                continue;
+            }
+            TaskInfo selectedTask = tasksQueue.takeFront(ready->poolInfo);
+            if (selectedTask.type == TaskType::Intensive)
+                queuedIntensiveTasks.fetch_sub(1, std::memory_order_relaxed);
+            selectedTasks.emplace_back(allWorkers[static_cast<size_t>(workerId)], std::move(selectedTask));
+            taskSelected = true;
+            break;
+        }
+        if (!taskSelected)
+            break;
+    }
+    lock.unlock();
+    // Only workers that received a task are woken up
+    for (auto &[worker, task] : selectedTasks)
+        worker->addTask(std::move(task));
+}
+
 bool TasksDispatcherPrivate::createNewWorkerIfPossible() noexcept
 {
     int32_t newWorkerId = static_cast<int32_t>(allWorkers.size());
-    if (newWorkerId < capacity) {
+    if (newWorkerId < capacity.load(std::memory_order_relaxed)) {
         try {
-            availableWorkers[newWorkerId] = true;
+            // Both bitsets are grown here, so later changes of them never allocate
+            boundWorkers.reserve(newWorkerId + 1);
+            availableWorkers.set(newWorkerId);
         } catch (...) {
             return false;
         }
@@ -442,6 +673,8 @@ bool TasksDispatcherPrivate::createNewWorkerIfPossible() noexcept
             delete worker;
             return false;
         }
+        stealers[static_cast<size_t>(newWorkerId)].store(worker, std::memory_order_release);
+        stealersCount.store(newWorkerId + 1, std::memory_order_release);
         worker->start();
         return true;
     }
@@ -453,12 +686,16 @@ bool TasksDispatcherPrivate::scheduleSingleTask(const TaskInfo &task, int32_t wo
     if (workerId < 0 || task.type == TaskType::ThreadBound)
         return false;
 
-    int32_t capacityLeft = capacity;
+    if (task.type == TaskType::Intensive) {
+        if (!tryAcquireIntensiveSlot())
+            return false;
+        availableWorkers.reset(workerId);
+        return true;
+    }
+
+    int32_t capacityLeft = capacity.load(std::memory_order_relaxed);
 
     switch (task.type) {
-    case TaskType::Intensive:
-        capacityLeft = INTENSIVE_CAPACITY;
-        break;
     case TaskType::Custom:
         capacityLeft = isCustomTagPaused(task.tag) ? 0 : customTagCapacity(task.tag);
         break;
@@ -471,7 +708,9 @@ bool TasksDispatcherPrivate::scheduleSingleTask(const TaskInfo &task, int32_t wo
     if (capacityLeft <= 0)
         return false;
     ++subPoolsUsage[poolInfo];
-    availableWorkers[workerId] = false;
+    if (capacityLeft == 1)
+        updateCustomSubPoolAvailability(task.tag);
+    availableWorkers.reset(workerId);
     return true;
 }
 
@@ -485,6 +724,295 @@ bool TasksDispatcherPrivate::isCustomTagPaused(int32_t tag) const
     return pausedCustomTags.count(tag);
 }
 
+void TasksDispatcherPrivate::updateCustomSubPoolAvailability(int32_t tag) noexcept
+{
+    uint64_t poolInfo = packPoolInfo(TaskType::Custom, tag);
+    bool blocked = isCustomTagPaused(tag);
+    if (!blocked) {
+        auto usageIt = subPoolsUsage.find(poolInfo);
+        blocked = subPoolsUsage.cend() != usageIt && usageIt->second >= customTagCapacity(tag);
+    }
+    try {
+        tasksQueue.setBlocked(poolInfo, blocked);
+    } catch (...) {
+    }
+}
+
+bool TasksDispatcherPrivate::isStealable(TaskType type, int32_t tag, TaskPriority priority) const noexcept
+{
+    if (!workStealingEnabled.load(std::memory_order_relaxed) || priority != TaskPriority::Regular)
+        return false;
+    // Untagged custom subpool has capacity of whole pool, so it never limits anything
+    return type == TaskType::Intensive || (type == TaskType::Custom && tag == 0);
+}
+
+bool TasksDispatcherPrivate::insertStealableTask(TaskInfo &task) noexcept
+{
+    StealableLane lane = stealableLane(task.type);
+    TaskInfo *node = nullptr;
+    instantUsage.add(1);
+    try {
+        node = new TaskInfo(std::move(task));
+        // Tasks spawned by worker are kept in its own deque. Owner takes them in LIFO order while they are still hot
+        // in its cache, other workers can steal them from the other end.
+        bool spawnedLocally = false;
+        if (currentWorker) {
+            try {
+                currentWorker->localTasks[lane].push(node);
+                spawnedLocally = true;
+            } catch (...) {
+            }
+        }
+        if (!spawnedLocally) {
+            detail::SpinLockHolder lock(&stealableTasks[lane].injectedLock);
+            stealableTasks[lane].injected.push_back(node);
+        }
+    } catch (...) {
+        if (node) {
+            task = std::move(*node);
+            delete node;
+        }
+        instantUsage.sub(1);
+        return false;
+    }
+    stealableTasks[lane].pending.fetch_add(1, std::memory_order_seq_cst);
+    wakeIdleStealer(lane);
+    return true;
+}
+
+size_t TasksDispatcherPrivate::insertStealableTasks(std::vector<detail::TaskFunction> &wrappedTasks, TaskType type,
+                                                   int32_t tag) noexcept
+{
+    StealableLane lane = stealableLane(type);
+    size_t inserted = 0;
+    TaskInfo *node = nullptr;
+    instantUsage.add(static_cast<int_fast32_t>(wrappedTasks.size()));
+    try {
+        std::optional<detail::SpinLockHolder> lock;
+        for (; inserted < wrappedTasks.size(); ++inserted) {
+            node = new TaskInfo(std::move(wrappedTasks[inserted]), type, tag, TaskPriority::Regular);
+            if (currentWorker) {
+                currentWorker->localTasks[lane].push(node);
+            } else {
+                if (!lock)
+                    lock.emplace(&stealableTasks[lane].injectedLock);
+                stealableTasks[lane].injected.push_back(node);
+            }
+            node = nullptr;
+        }
+    } catch (...) {
+        if (node) {
+            wrappedTasks[inserted] = std::move(node->task);
+            delete node;
+        }
+    }
+    instantUsage.sub(static_cast<int_fast32_t>(wrappedTasks.size() - inserted));
+    if (!inserted)
+        return 0;
+    stealableTasks[lane].pending.fetch_add(static_cast<int_fast32_t>(inserted), std::memory_order_seq_cst);
+    for (size_t i = 0; i < inserted && wakeIdleStealer(lane); ++i) {
+    }
+    return inserted;
+}
+
+TaskInfo *TasksDispatcherPrivate::takeStealableTask(Worker *worker) noexcept
+{
+    for (uint8_t i = 0; i < StealableLanesCount; ++i) {
+        auto lane = static_cast<StealableLane>(i);
+        if (stealableTasks[lane].pending.load(std::memory_order_acquire) <= 0)
+            continue;
+        if (lane == IntensiveLane && !tryAcquireIntensiveSlot())
+            continue;
+        TaskInfo *task = worker->localTasks[lane].pop();
+        if (!task && canSteal(worker)) {
+            task = takeInjectedTasks(worker, lane);
+            if (!task)
+                task = stealFromPeers(worker, lane);
+        }
+        if (task) {
+            stealableTasks[lane].pending.fetch_sub(1, std::memory_order_relaxed);
+            return task;
+        }
+        // Slot is returned silently here, task we missed is already taken by someone else
+        if (lane == IntensiveLane)
+            intensiveUsage.fetch_sub(1, std::memory_order_seq_cst);
+    }
+    return nullptr;
+}
+
+void TasksDispatcherPrivate::stealableTaskFinished(Worker *worker, TaskType type) noexcept
+{
+    if (type != TaskType::Intensive)
+        return;
+    // If worker has its own intensive tasks it will take freed slot by itself right away
+    if (worker->localTasks[IntensiveLane].empty())
+        releaseIntensiveSlot();
+    else
+        intensiveUsage.fetch_sub(1, std::memory_order_seq_cst);
+    // Intensive tasks with non-regular priority are still in tasksQueue and could wait for this slot
+    if (queuedIntensiveTasks.load(std::memory_order_relaxed) > 0)
+        schedule();
+}
+
+bool TasksDispatcherPrivate::hasRunnableStealableTasks() const noexcept
+{
+    return stealableTasks[CustomLane].pending.load(std::memory_order_seq_cst) > 0
+           || (stealableTasks[IntensiveLane].pending.load(std::memory_order_seq_cst) > 0
+               && intensiveUsage.load(std::memory_order_seq_cst) < INTENSIVE_CAPACITY);
+}
+
+bool TasksDispatcherPrivate::canSteal(const Worker *worker) const noexcept
+{
+    // Same as with shared queue, bound workers are used for other tasks only if there are no other options
+    return !worker->isBound()
+           || (stealersCount.load(std::memory_order_relaxed) >= capacity.load(std::memory_order_relaxed)
+               && idleStealersCount.load(std::memory_order_relaxed) == 0);
+}
+
+void TasksDispatcherPrivate::registerIdleStealer(const Worker *worker) noexcept
+{
+    try {
+        detail::SpinLockHolder lock(&idleStealersLock);
+        if (worker->isBound()) {
+            idleBoundStealers.push_back(worker->workerId());
+        } else {
+            idleStealers.push_back(worker->workerId());
+            idleStealersCount.fetch_add(1, std::memory_order_seq_cst);
+        }
+    } catch (...) {
+    }
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+}
+
+void TasksDispatcherPrivate::unregisterIdleStealer(int32_t workerId) noexcept
+{
+    detail::SpinLockHolder lock(&idleStealersLock);
+    auto it = std::find(idleStealers.begin(), idleStealers.end(), workerId);
+    if (it != idleStealers.end()) {
+        idleStealers.erase(it);
+        idleStealersCount.fetch_sub(1, std::memory_order_relaxed);
+        return;
+    }
+    it = std::find(idleBoundStealers.begin(), idleBoundStealers.end(), workerId);
+    if (it != idleBoundStealers.end())
+        idleBoundStealers.erase(it);
+}
+
+void TasksDispatcherPrivate::wakeIdleStealerIfNeeded() noexcept
+{
+    for (uint8_t i = 0; i < StealableLanesCount; ++i) {
+        auto lane = static_cast<StealableLane>(i);
+        if (stealableTasks[lane].pending.load(std::memory_order_relaxed) > 0)
+            wakeIdleStealer(lane);
+    }
+}
+
+bool TasksDispatcherPrivate::tryAcquireIntensiveSlot() noexcept
+{
+    auto usage = intensiveUsage.load(std::memory_order_relaxed);
+    while (usage < INTENSIVE_CAPACITY) {
+        if (intensiveUsage.compare_exchange_weak(usage, usage + 1, std::memory_order_seq_cst,
+                                                 std::memory_order_relaxed)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TasksDispatcherPrivate::releaseIntensiveSlot() noexcept
+{
+    intensiveUsage.fetch_sub(1, std::memory_order_seq_cst);
+    if (stealableTasks[IntensiveLane].pending.load(std::memory_order_seq_cst) > 0)
+        wakeIdleStealer(IntensiveLane);
+}
+
+TaskInfo *TasksDispatcherPrivate::takeInjectedTasks(Worker *worker, StealableLane lane) noexcept
+{
+    StealableTasks &tasks = stealableTasks[lane];
+    if (tasks.pending.load(std::memory_order_relaxed) <= 0)
+        return nullptr;
+    detail::SpinLockHolder lock(&tasks.injectedLock);
+    if (tasks.injected.empty())
+        return nullptr;
+    TaskInfo *result = tasks.injected.front();
+    tasks.injected.pop_front();
+
+    // Part of remaining tasks is moved to worker deque, so other workers can steal them without touching this lock.
+    // They are pushed in reversed order to be popped by owner in the same order they were submitted.
+    auto stealersAmount = static_cast<size_t>(std::max(1, stealersCount.load(std::memory_order_relaxed)));
+    size_t batchSize = std::min(MAX_INJECTED_BATCH, tasks.injected.size() / stealersAmount);
+    size_t notMoved = batchSize;
+    try {
+        for (; notMoved > 0; --notMoved)
+            worker->localTasks[lane].push(tasks.injected[notMoved - 1]);
+    } catch (...) {
+    }
+    tasks.injected.erase(tasks.injected.begin() + static_cast<std::ptrdiff_t>(notMoved),
+                         tasks.injected.begin() + static_cast<std::ptrdiff_t>(batchSize));
+    return result;
+}
+
+TaskInfo *TasksDispatcherPrivate::stealFromPeers(Worker *worker, StealableLane lane) noexcept
+{
+    static thread_local uint32_t randomState = static_cast<uint32_t>(
+        std::hash<std::thread::id>()(std::this_thread::get_id()) | 1u);
+    int32_t amount = stealersCount.load(std::memory_order_acquire);
+    if (amount <= 1)
+        return nullptr;
+    // xorshift is enough here, we only need to spread thieves across victims
+    randomState ^= randomState << 13u;
+    randomState ^= randomState >> 17u;
+    randomState ^= randomState << 5u;
+    auto start = static_cast<int32_t>(randomState % static_cast<uint32_t>(amount));
+    for (int32_t i = 0; i < amount; ++i) {
+        Worker *victim = stealers[static_cast<size_t>((start + i) % amount)].load(std::memory_order_acquire);
+        if (!victim || victim == worker)
+            continue;
+        if (TaskInfo *task = victim->localTasks[lane].steal())
+            return task;
+    }
+    return nullptr;
+}
+
+bool TasksDispatcherPrivate::wakeIdleStealer(StealableLane lane) noexcept
+{
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (lane == IntensiveLane && intensiveUsage.load(std::memory_order_relaxed) >= INTENSIVE_CAPACITY)
+        return false;
+    // Searching workers will find these tasks by themselves
+    auto pending = stealableTasks[lane].pending.load(std::memory_order_seq_cst);
+    if (searchingStealers.load(std::memory_order_seq_cst) >= pending)
+        return false;
+    if (idleStealersCount.load(std::memory_order_relaxed) > 0) {
+        detail::SpinLockHolder lock(&idleStealersLock);
+        if (!idleStealers.empty()) {
+            int32_t workerId = idleStealers.back();
+            idleStealers.pop_back();
+            idleStealersCount.fetch_sub(1, std::memory_order_relaxed);
+            lock.unlock();
+            stealers[static_cast<size_t>(workerId)].load(std::memory_order_acquire)->wakeUp();
+            return true;
+        }
+    }
+    // Pool is usually already at capacity here, so mainLock is taken only if new worker could be created
+    if (stealersCount.load(std::memory_order_acquire) < capacity.load(std::memory_order_relaxed)) {
+        detail::SpinLockHolder lock(&mainLock, poisoningStarted);
+        if (!lock.isLocked())
+            return false;
+        if (createNewWorkerIfPossible())
+            return true;
+    }
+    detail::SpinLockHolder lock(&idleStealersLock);
+    if (!idleBoundStealers.empty()) {
+        int32_t workerId = idleBoundStealers.back();
+        idleBoundStealers.pop_back();
+        lock.unlock();
+        stealers[static_cast<size_t>(workerId)].load(std::memory_order_acquire)->wakeUp();
+        return true;
+    }
+    return false;
+}
+
 Worker::Worker(int32_t id) : id(id)
 {
     idleLoopsAmount = TasksDispatcher::instance()->d_ptr->idleLoopsAmount.load(std::memory_order_relaxed);
@@ -493,11 +1021,10 @@ Worker::Worker(int32_t id) : id(id)
 Worker::~Worker()
 {
     poisonPill();
-    if (myself.joinable()) {
-        try {
-            myself.join();
-        } catch (...) {
-        }
+    join();
+    for (auto &deque : localTasks) {
+        for (TaskInfo *task = deque.pop(); task; task = deque.pop())
+            delete task;
     }
 }
 
@@ -511,62 +1038,150 @@ void Worker::addTask(TaskInfo &&task) noexcept
 {
     try {
         detail::SpinLockHolder lock(&tasksLock);
-        bool wasEmpty = workerTasks.empty();
         workerTasks.push_back(std::move(task));
-        if (wasEmpty) {
-            std::lock_guard waitLock(waitingLock);
-            waiter.notify_one();
-        }
+        workerTasksCount.fetch_add(1, std::memory_order_release);
     } catch (...) {
     }
-    TasksDispatcher::instance()->d_ptr->instantUsage.fetch_add(1, std::memory_order_relaxed);
+    events.notify();
+    TasksDispatcher::instance()->d_ptr->instantUsage.add(1);
+}
+
+void Worker::addTasks(std::vector<detail::TaskFunction> &&wrappedTasks, TaskType type, int32_t tag,
+                      TaskPriority priority) noexcept
+{
+    int_fast32_t added = 0;
+    {
+        detail::SpinLockHolder lock(&tasksLock);
+        try {
+            for (auto &wrappedTask : wrappedTasks) {
+                workerTasks.emplace_back(std::move(wrappedTask), type, tag, priority);
+                ++added;
+            }
+        } catch (...) {
+        }
+        workerTasksCount.fetch_add(static_cast<int32_t>(added), std::memory_order_release);
+    }
+    events.notify();
+    TasksDispatcher::instance()->d_ptr->instantUsage.add(added);
+}
+
+void Worker::wakeUp() noexcept
+{
+    events.notify();
 }
 
 void Worker::poisonPill()
 {
     poisoned.store(true, std::memory_order_relaxed);
-    std::lock_guard lock(waitingLock);
-    waiter.notify_one();
+    events.notify();
+}
+
+void Worker::join()
+{
+    if (myself.joinable()) {
+        try {
+            myself.join();
+        } catch (...) {
+        }
+    }
 }
 
 void Worker::run()
 {
+    currentWorker = this;
+    TasksDispatcherPrivate *dispatcher = TasksDispatcher::instance()->d_ptr.get();
     TaskInfo task;
+    TaskInfo *stealableTask = nullptr;
     bool taskFound = false;
     bool taskObserved = false;
+    bool searching = false;
     long long noTasksTicks = 0;
     while (!poisoned.load(std::memory_order_relaxed)) {
         taskFound = false;
-        tasksLock.lock();
-        if (!workerTasks.empty()) {
-            task = std::move(workerTasks.front());
-            workerTasks.pop_front();
-            taskFound = true;
-            taskObserved = true;
+        if (workerTasksCount.load(std::memory_order_acquire) > 0) {
+            tasksLock.lock();
+            if (!workerTasks.empty()) {
+                task = std::move(workerTasks.front());
+                workerTasks.pop_front();
+                workerTasksCount.fetch_sub(1, std::memory_order_relaxed);
+                taskFound = true;
+            }
+            tasksLock.unlock();
+        }
+        if (!taskFound) {
+            stealableTask = dispatcher->takeStealableTask(this);
+            taskFound = stealableTask;
         }
         if (!taskFound) {
+            if (!searching && !isBound()) {
+                searching = true;
+                dispatcher->searchingStealers.fetch_add(1, std::memory_order_relaxed);
+            }
             if (taskObserved && ++noTasksTicks < idleLoopsAmount) {
-                tasksLock.unlock();
-                std::this_thread::yield();
+                for (int i = 0; i < IDLE_LOOP_PAUSES; ++i)
+                    detail::cpuRelax();
+                continue;
+            }
+            // Waiting is announced before recheck, so any notification after this point will not be missed
+            detail::EventCount::Key waitKey = events.prepareWait();
+            bool hasWorkerTasks = workerTasksCount.load(std::memory_order_seq_cst) > 0;
+            if (hasWorkerTasks || poisoned.load(std::memory_order_relaxed)) {
+                events.cancelWait(waitKey);
+                continue;
+            }
+            dispatcher->registerIdleStealer(this);
+            if (searching) {
+                searching = false;
+                dispatcher->searchingStealers.fetch_sub(1, std::memory_order_seq_cst);
+            }
+            bool hasLocalTasks = std::any_of(localTasks.cbegin(), localTasks.cend(),
+                                             [](const auto &deque) { return !deque.empty(); });
+            if (hasLocalTasks || (dispatcher->canSteal(this) && dispatcher->hasRunnableStealableTasks())) {
+                dispatcher->unregisterIdleStealer(id);
+                events.cancelWait(waitKey);
                 continue;
             }
-            std::unique_lock lock(waitingLock);
-            tasksLock.unlock();
             task = TaskInfo();
-            waiter.wait(lock);
-            idleLoopsAmount = TasksDispatcher::instance()->d_ptr->idleLoopsAmount.load(std::memory_order_relaxed);
+            events.wait(waitKey);
+            dispatcher->unregisterIdleStealer(id);
+            // Worker could become bound while parked, so this wake up could be meant for someone else
+            if (!dispatcher->canSteal(this))
+                dispatcher->wakeIdleStealerIfNeeded();
+            idleLoopsAmount = dispatcher->idleLoopsAmount.load(std::memory_order_relaxed);
             taskObserved = false;
             noTasksTicks = 0;
             continue;
         }
-        tasksLock.unlock();
+        taskObserved = true;
+        if (searching) {
+            searching = false;
+            dispatcher->searchingStealers.fetch_sub(1, std::memory_order_relaxed);
+            // This worker was counted as one that will pick pending tasks, so someone else should do it now
+            if (stealableTask)
+                dispatcher->wakeIdleStealerIfNeeded();
+        }
+
+        if (stealableTask) {
+            currentSubPool = packPoolInfo(*stealableTask);
+            stealableTask->task();
+            currentSubPool = NO_SUBPOOL;
+            TaskType stealableType = stealableTask->type;
+            delete stealableTask;
+            stealableTask = nullptr;
+            dispatcher->stealableTaskFinished(this, stealableType);
+            dispatcher->instantUsage.sub(1);
+            continue;
+        }
+
+        currentSubPool = packPoolInfo(task);
         task.task();
-        tasksLock.lock();
-        bool askingForNext = workerTasks.empty();
-        tasksLock.unlock();
-        TasksDispatcher::instance()->d_ptr->taskFinished(id, task, askingForNext);
-        TasksDispatcher::instance()->d_ptr->instantUsage.fetch_sub(1, std::memory_order_relaxed);
+        currentSubPool = NO_SUBPOOL;
+        bool askingForNext = workerTasksCount.load(std::memory_order_acquire) == 0;
+        dispatcher->taskFinished(id, task, askingForNext);
+        dispatcher->instantUsage.sub(1);
     }
+    if (searching)
+        dispatcher->searchingStealers.fetch_sub(1, std::memory_order_relaxed);
 }
 
 } // namespace asynqro::tasks
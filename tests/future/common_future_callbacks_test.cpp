@@ -116,3 +116,28 @@ TEST_F(FutureCallbacksTest, multipleOnCompleteFailure)
     for (int i : result)
         EXPECT_EQ(42, i);
 }
+
+TEST_F(FutureCallbacksTest, onSuccessMovableOnlyCallback)
+{
+    TestPromise<int> promise;
+    auto future = createFuture(promise);
+    int result = 0;
+    auto multiplier = std::make_unique<int>(2);
+    future.onSuccess([&result, multiplier = std::move(multiplier)](int x) { result = x * *multiplier; });
+    promise.success(21);
+    EXPECT_EQ(42, result);
+}
+
+TEST_F(FutureCallbacksTest, manyCallbacks)
+{
+    TestPromise<int> promise;
+    auto future = createFuture(promise);
+    std::vector<int> order;
+    for (int i = 0; i < 10; ++i) {
+        future.onSuccess([&order, i](int) { order.push_back(i); });
+        future.onFailure([&order, i](const std::string &) { order.push_back(-i); });
+    }
+    promise.success(42);
+    std::vector<int> expected = {0, 1, 2, 3, 4, 5, 6, 7, 8, 9};
+    EXPECT_EQ(expected, order);
+}
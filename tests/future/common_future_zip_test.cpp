@@ -113,6 +113,50 @@ TEST_F(FutureZipTest, zipRightFails)
     EXPECT_EQ("failed", future.failureReason());
 }
 
+TEST_F(FutureZipTest, zipManySingleState)
+{
+    TestPromise<int> firstPromise;
+    TestPromise<double> secondPromise;
+    TestPromise<std::string> thirdPromise;
+    TestPromise<int> fourthPromise;
+    auto first = createFuture(firstPromise);
+    auto second = createFuture(secondPromise);
+    auto third = createFuture(thirdPromise);
+    auto fourth = createFuture(fourthPromise);
+    auto futuresBefore = instantFuturesUsage();
+    TestFuture<std::tuple<int, double, std::string, int>> future = first.zip(second, third, fourth);
+    // No intermediate futures are created
+    EXPECT_EQ(futuresBefore + 1, instantFuturesUsage());
+    fourthPromise.success(1024);
+    thirdPromise.success("Done");
+    EXPECT_FALSE(future.isCompleted());
+    firstPromise.success(42);
+    EXPECT_FALSE(future.isCompleted());
+    secondPromise.success(5.0);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, std::get<0>(future.result()));
+    EXPECT_DOUBLE_EQ(5.0, std::get<1>(future.result()));
+    EXPECT_EQ("Done", std::get<2>(future.result()));
+    EXPECT_EQ(1024, std::get<3>(future.result()));
+}
+
+TEST_F(FutureZipTest, zipManyFailsOnFirstFailure)
+{
+    TestPromise<int> firstPromise;
+    TestPromise<double> secondPromise;
+    Promise<int, double> thirdPromise;
+    Future<std::tuple<int, double, int>, std::variant<std::string, double>> future =
+        createFuture(firstPromise).zip(createFuture(secondPromise), thirdPromise.future());
+    thirdPromise.failure(2.0);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_DOUBLE_EQ(2.0, std::get<double>(future.failureReason()));
+    firstPromise.failure("failed");
+    secondPromise.success(5.0);
+    EXPECT_DOUBLE_EQ(2.0, std::get<double>(future.failureReason()));
+}
+
 TEST_F(FutureZipTest, zipValue)
 {
     TestPromise<double> firstPromise;
@@ -16,6 +16,32 @@ signals:
 };
 #endif
 
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Counts only allocations made by current thread while it is enabled
+thread_local bool allocationsCountingEnabled = false;
+thread_local int64_t allocationsCount = 0;
+} // namespace
+
+void *operator new(std::size_t size)
+{
+    if (allocationsCountingEnabled)
+        ++allocationsCount;
+    if (void *result = std::malloc(size ? size : 1))
+        return result;
+    throw std::bad_alloc();
+}
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
 class FutureBasicsTest : public FutureBaseTest
 {};
 
@@ -819,6 +845,220 @@ TEST_F(FutureBasicsTest, waitInFailureReason)
     EXPECT_TRUE(future.failureReason().empty());
 }
 
+TEST_F(FutureBasicsTest, waitSeveralWaiters)
+{
+    TestPromise<int> promise;
+    TestFuture<int> future = promise.future();
+    std::atomic_int completedWaiters = 0;
+    std::vector<std::thread> waiters;
+    for (int i = 0; i < 4; ++i) {
+        waiters.emplace_back([future, &completedWaiters]() {
+            if (future.wait())
+                ++completedWaiters;
+        });
+    }
+    std::this_thread::sleep_for(100ms);
+    EXPECT_EQ(0, completedWaiters);
+    promise.success(42);
+    for (auto &waiter : waiters)
+        waiter.join();
+    EXPECT_EQ(4, completedWaiters);
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(FutureBasicsTest, waitMany)
+{
+    for (int i = 0; i < 1000; ++i) {
+        TestPromise<int> promise;
+        TestFuture<int> future = promise.future();
+        std::thread filler([promise, i]() { promise.success(i); });
+        EXPECT_TRUE(future.wait());
+        filler.join();
+        ASSERT_TRUE(future.isCompleted());
+        EXPECT_EQ(i, future.result());
+    }
+}
+
+TEST_F(FutureBasicsTest, waitAll)
+{
+    std::vector<TestPromise<int>> promises(3);
+    std::vector<TestFuture<int>> futures;
+    for (const auto &promise : promises)
+        futures.push_back(promise.future());
+    promises[1].success(1);
+    std::thread([promises]() {
+        std::this_thread::sleep_for(100ms);
+        promises[0].success(0);
+        std::this_thread::sleep_for(100ms);
+        promises[2].failure("failed");
+    }).detach();
+    bool result = waitAll(futures, 30s);
+    EXPECT_TRUE(result);
+    for (const auto &future : futures)
+        EXPECT_TRUE(future.isCompleted());
+    EXPECT_TRUE(futures[2].isFailed());
+}
+
+TEST_F(FutureBasicsTest, waitAllTimedNegative)
+{
+    std::vector<TestPromise<int>> promises(3);
+    std::vector<TestFuture<int>> futures;
+    for (const auto &promise : promises)
+        futures.push_back(promise.future());
+    promises[0].success(0);
+    promises[1].success(1);
+    bool result = waitAll(futures, 200);
+    EXPECT_FALSE(result);
+    EXPECT_FALSE(futures[2].isCompleted());
+    promises[2].success(2);
+}
+
+TEST_F(FutureBasicsTest, waitAllEmpty)
+{
+    std::vector<TestFuture<int>> futures;
+    EXPECT_TRUE(waitAll(futures));
+    EXPECT_TRUE(waitAny(futures));
+}
+
+TEST_F(FutureBasicsTest, waitAny)
+{
+    std::vector<TestPromise<int>> promises(3);
+    std::vector<TestFuture<int>> futures;
+    for (const auto &promise : promises)
+        futures.push_back(promise.future());
+    std::thread([promises]() {
+        std::this_thread::sleep_for(100ms);
+        promises[1].success(1);
+    }).detach();
+    bool result = waitAny(futures);
+    EXPECT_TRUE(result);
+    EXPECT_TRUE(futures[1].isCompleted());
+    promises[0].success(0);
+    promises[2].success(2);
+}
+
+TEST_F(FutureBasicsTest, waitAnyTimedNegative)
+{
+    std::vector<TestPromise<int>> promises(3);
+    std::vector<TestFuture<int>> futures;
+    for (const auto &promise : promises)
+        futures.push_back(promise.future());
+    bool result = waitAny(futures, 200ms);
+    EXPECT_FALSE(result);
+    for (const auto &future : futures)
+        EXPECT_FALSE(future.isCompleted());
+    for (const auto &promise : promises)
+        promise.success(0);
+}
+
+TEST_F(FutureBasicsTest, repeatedTimedWaitsDontAllocate)
+{
+    TestPromise<int> promise;
+    std::vector<TestFuture<int>> futures = {promise.future(), TestFuture<int>::successful(1)};
+    std::vector<TestFuture<int>> pending = {promise.future()};
+    EXPECT_FALSE(waitAll(futures, 1ms));
+    allocationsCount = 0;
+    allocationsCountingEnabled = true;
+    bool anyCompleted = false;
+    for (int i = 0; i < 100 && !anyCompleted; ++i)
+        anyCompleted = waitAll(futures, 1ms) || waitAny(pending, 1ms);
+    allocationsCountingEnabled = false;
+    EXPECT_FALSE(anyCompleted);
+    EXPECT_EQ(0, allocationsCount);
+    promise.success(42);
+    EXPECT_TRUE(waitAll(futures, 1ms));
+    EXPECT_TRUE(waitAny(pending, 1ms));
+}
+
+TEST_F(FutureBasicsTest, continuationsDepthLimit)
+{
+    int32_t oldLimit = continuationsDepthLimit();
+    setContinuationsDepthLimit(16);
+    EXPECT_EQ(16, continuationsDepthLimit());
+    setContinuationsDepthLimit(-5);
+    EXPECT_EQ(1, continuationsDepthLimit());
+    setContinuationsDepthLimit(oldLimit);
+    EXPECT_EQ(oldLimit, continuationsDepthLimit());
+}
+
+TEST_F(FutureBasicsTest, shallowChainIsSynchronous)
+{
+    TestPromise<int> promise;
+    TestFuture<int> future = promise.future();
+    for (int i = 0; i < continuationsDepthLimit() / 4; ++i)
+        future = future.flatMap([](int x) { return TestFuture<int>::successful(x + 1); });
+    promise.success(0);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(continuationsDepthLimit() / 4, future.result());
+}
+
+TEST_F(FutureBasicsTest, deepChainIsTrampolined)
+{
+    const int depth = 300000;
+    std::vector<TestPromise<int>> promises(depth);
+    TestFuture<int> future = promises[0].future();
+    for (int i = 1; i < depth; ++i)
+        future = future.flatMap([p = promises[i]](int) { return p.future(); });
+    for (int i = depth - 1; i > 0; --i)
+        promises[i].success(i);
+    promises[0].success(0);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(depth - 1, future.result());
+}
+
+TEST_F(FutureBasicsTest, deepBackwardFillIsTrampolined)
+{
+    const int depth = 300000;
+    std::vector<TestPromise<int>> promises(depth);
+    for (int i = 0; i < depth - 1; ++i)
+        promises[i].future().onSuccess([next = promises[i + 1]](int x) { next.success(x + 1); });
+    TestFuture<int> future = promises[depth - 1].future();
+    promises[0].success(0);
+    ASSERT_TRUE(future.wait());
+    EXPECT_EQ(depth - 1, future.result());
+}
+
+TEST_F(FutureBasicsTest, waitAllInDeepContinuation)
+{
+    int32_t oldLimit = continuationsDepthLimit();
+    setContinuationsDepthLimit(1);
+    TestPromise<int> outer;
+    TestPromise<int> inner;
+    TestPromise<int> filledByInner;
+    inner.future().onSuccess([filledByInner](int x) { filledByInner.success(x); });
+    std::atomic_bool allResult{false};
+    std::atomic_bool anyResult{false};
+    outer.future().onSuccess([&](int) {
+        // Both continuations of inner and callbacks on completed futures are deferred here
+        inner.success(42);
+        std::vector<TestFuture<int>> futures = {TestFuture<int>::successful(1), filledByInner.future()};
+        allResult = waitAll(futures, 5s);
+        anyResult = waitAny(std::vector<TestFuture<int>>{filledByInner.future()}, 5s);
+    });
+    outer.success(0);
+    setContinuationsDepthLimit(oldLimit);
+    EXPECT_TRUE(allResult);
+    EXPECT_TRUE(anyResult);
+    ASSERT_TRUE(filledByInner.future().isCompleted());
+    EXPECT_EQ(42, filledByInner.future().result());
+}
+
+TEST_F(FutureBasicsTest, overAlignedValue)
+{
+    struct alignas(128) OverAligned
+    {
+        int value = 0;
+    };
+    std::vector<Future<OverAligned, std::string>> futures;
+    for (int i = 0; i < 10; ++i)
+        futures.push_back(Future<OverAligned, std::string>::successful(OverAligned{i}));
+    for (int i = 0; i < 10; ++i) {
+        const OverAligned &result = futures[static_cast<size_t>(i)].result();
+        EXPECT_EQ(0, reinterpret_cast<uintptr_t>(&result) % alignof(OverAligned));
+        EXPECT_EQ(i, result.value);
+    }
+}
+
 TEST_F(FutureBasicsTest, isValid)
 {
     TestFuture<int> invalid;
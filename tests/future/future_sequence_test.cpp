@@ -109,14 +109,14 @@ TYPED_TEST(FutureSequenceTest, sequenceNegative)
         EXPECT_FALSE(it->isCompleted()) << i;
     EXPECT_FALSE(sequencedFuture.isCompleted());
 
-    promises[TestFixture::N - 2].failure("failed");
     for (size_t i = 0; i < TestFixture::N - 3; ++i) {
         promises[i].success(i * 2);
         EXPECT_FALSE(sequencedFuture.isCompleted()) << i;
     }
-    promises[TestFixture::N - 3].success(42);
-    sequencedFuture.wait(1000);
+    // First failure completes sequence without waiting for the rest
+    promises[TestFixture::N - 2].failure("failed");
     ASSERT_TRUE(sequencedFuture.isCompleted());
+    promises[TestFixture::N - 3].success(42);
     EXPECT_FALSE(sequencedFuture.isSucceeded());
     EXPECT_TRUE(sequencedFuture.isFailed());
     EXPECT_EQ("failed", sequencedFuture.failureReason());
@@ -166,6 +166,41 @@ TYPED_TEST(FutureSequenceTest, sequenceEmpty)
     EXPECT_TRUE(result.empty());
 }
 
+TYPED_TEST(FutureSequenceTest, sequenceCompleted)
+{
+    typename TestFixture::Source futures;
+    for (int i = 0; i < TestFixture::N; ++i)
+        asynqro::traverse::detail::containers::add(futures, TestFuture<int>::successful(i * 2));
+    typename TestFixture::ResultFuture sequencedFuture = TestFuture<int>::sequence(futures);
+    ASSERT_TRUE(sequencedFuture.isCompleted());
+    EXPECT_TRUE(sequencedFuture.isSucceeded());
+    typename TestFixture::Result result = sequencedFuture.result();
+    int i = 0;
+    for (auto it = result.cbegin(); it != result.cend(); ++it, ++i)
+        EXPECT_EQ(i * 2, *it) << i;
+    ASSERT_EQ(TestFixture::N, i);
+}
+
+TYPED_TEST(FutureSequenceTest, sequenceReversedFill)
+{
+    const int n = 10000;
+    std::vector<TestPromise<int>> promises(n);
+    typename TestFixture::Source futures = traverse::map(
+        promises, [](const auto &p) { return p.future(); }, typename TestFixture::Source());
+    typename TestFixture::ResultFuture sequencedFuture = TestFuture<int>::sequence(futures);
+    for (int i = n - 1; i >= 0; --i) {
+        EXPECT_FALSE(sequencedFuture.isCompleted()) << i;
+        promises[i].success(i * 2);
+    }
+    ASSERT_TRUE(sequencedFuture.isCompleted());
+    EXPECT_TRUE(sequencedFuture.isSucceeded());
+    typename TestFixture::Result result = sequencedFuture.result();
+    int i = 0;
+    for (auto it = result.cbegin(); it != result.cend(); ++it, ++i)
+        EXPECT_EQ(i * 2, *it) << i;
+    ASSERT_EQ(n, i);
+}
+
 TYPED_TEST_SUITE(FutureMoveSequenceTest, CopyCountSequenceTypes);
 
 TYPED_TEST(FutureMoveSequenceTest, sequenceMove)
@@ -205,22 +240,19 @@ TYPED_TEST(FutureMoveSequenceTest, sequenceNegative)
         promises, [](const auto &p) { return p.future(); }, std::move(typename TestFixture::Source())));
 
     promises[TestFixture::N - 2].failure("failed");
-    EXPECT_FALSE(sequencedFuture.isCompleted());
-    for (size_t i = 0; i < TestFixture::N - 3; ++i) {
+    // First failure completes sequence without waiting for the rest
+    ASSERT_TRUE(sequencedFuture.isCompleted());
+    for (size_t i = 0; i < TestFixture::N - 3; ++i)
         promises[i].success(i * 2);
-        EXPECT_FALSE(sequencedFuture.isCompleted()) << i;
-    }
     promises[TestFixture::N - 3].success(42);
-    sequencedFuture.wait(1000);
 
-    ASSERT_TRUE(sequencedFuture.isCompleted());
     EXPECT_FALSE(sequencedFuture.isSucceeded());
     EXPECT_TRUE(sequencedFuture.isFailed());
     EXPECT_EQ("failed", sequencedFuture.failureReason());
 
     EXPECT_EQ(0, TestFixture::Result::copyCounter);
     EXPECT_EQ(0, TestFixture::Source::copyCounter);
-    EXPECT_EQ(1, TestFixture::Result::createCounter);
+    EXPECT_EQ(0, TestFixture::Result::createCounter);
     EXPECT_EQ(1, TestFixture::Source::createCounter);
 }
 
@@ -256,6 +288,6 @@ TYPED_TEST(FutureMoveSequenceTest, sequenceNegativeDeferred)
 
     EXPECT_EQ(0, TestFixture::Result::copyCounter);
     EXPECT_EQ(0, TestFixture::Source::copyCounter);
-    EXPECT_EQ(1, TestFixture::Result::createCounter);
+    EXPECT_EQ(0, TestFixture::Result::createCounter);
     EXPECT_EQ(1, TestFixture::Source::createCounter);
 }
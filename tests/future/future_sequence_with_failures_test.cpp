@@ -260,6 +260,44 @@ TYPED_TEST(FutureSequenceWithFailuresTest, sequenceAllNegativeMap)
     });
 }
 
+TYPED_TEST(FutureSequenceWithFailuresTest, sequenceIndexed)
+{
+    std::vector<TestPromise<int>> promises;
+    for (int i = 0; i < TestFixture::N; ++i)
+        asynqro::traverse::detail::containers::add(promises, TestPromise<int>());
+    typename TestFixture::Source futures = traverse::map(
+        promises, [](const auto &p) { return p.future(); }, typename TestFixture::Source());
+    auto sequencedFuture = TestFuture<int>::sequenceWithFailures<std::vector>(futures);
+
+    for (size_t i = TestFixture::N; i > 0; --i) {
+        EXPECT_FALSE(sequencedFuture.isCompleted()) << i;
+        if (i - 1 == TestFixture::N - 2)
+            promises[i - 1].failure("failed");
+        else
+            promises[i - 1].success((i - 1) * 2);
+    }
+    ASSERT_TRUE(sequencedFuture.isCompleted());
+    EXPECT_TRUE(sequencedFuture.isSucceeded());
+
+    const auto &result = sequencedFuture.resultRef().first;
+    const auto &failures = sequencedFuture.resultRef().second;
+    static_assert(std::is_same_v<std::decay_t<decltype(result)>, std::vector<std::optional<int>>>);
+    static_assert(std::is_same_v<std::decay_t<decltype(failures)>, std::vector<std::optional<std::string>>>);
+    ASSERT_EQ(TestFixture::N, result.size());
+    ASSERT_EQ(TestFixture::N, failures.size());
+    for (int i = 0; i < TestFixture::N; ++i) {
+        if (i == TestFixture::N - 2) {
+            EXPECT_FALSE(result[i].has_value());
+            ASSERT_TRUE(failures[i].has_value());
+            EXPECT_EQ("failed", *failures[i]);
+        } else {
+            ASSERT_TRUE(result[i].has_value()) << i;
+            EXPECT_EQ(i * 2, *result[i]) << i;
+            EXPECT_FALSE(failures[i].has_value()) << i;
+        }
+    }
+}
+
 #ifdef ASYNQRO_QT_SUPPORT
 TYPED_TEST(FutureSequenceWithFailuresTest, sequenceAllNegativeQMap)
 {
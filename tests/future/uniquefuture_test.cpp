@@ -0,0 +1,342 @@
+#include "futurebasetest.h"
+
+#include <memory>
+#include <thread>
+
+template <typename T>
+using TestUniquePromise = UniquePromise<T, std::string>;
+template <typename T>
+using TestUniqueFuture = UniqueFuture<T, std::string>;
+
+class UniqueFutureTest : public CommonFutureBaseTest
+{};
+
+TEST_F(UniqueFutureTest, share)
+{
+    TestUniquePromise<int> promise;
+    TestUniqueFuture<int> uniqueFuture = promise.future();
+    EXPECT_TRUE(uniqueFuture.isValid());
+    EXPECT_FALSE(uniqueFuture.isCompleted());
+    TestFuture<int> future = std::move(uniqueFuture).share();
+    EXPECT_FALSE(uniqueFuture.isValid()); // NOLINT(bugprone-use-after-move)
+    EXPECT_FALSE(future.isCompleted());
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(UniqueFutureTest, shareCompleted)
+{
+    TestUniquePromise<int> promise;
+    TestUniqueFuture<int> uniqueFuture = promise.future();
+    promise.failure("failed");
+    EXPECT_TRUE(promise.isFilled());
+    EXPECT_TRUE(uniqueFuture.isCompleted());
+    TestFuture<int> future = std::move(uniqueFuture).share();
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, futureTakenOnce)
+{
+    TestUniquePromise<int> promise;
+    TestUniqueFuture<int> first = promise.future();
+    TestUniqueFuture<int> second = promise.future();
+    EXPECT_TRUE(first.isValid());
+    EXPECT_FALSE(second.isValid());
+}
+
+TEST_F(UniqueFutureTest, onlyFirstFillCounts)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<int> future = promise.future().share();
+    promise.success(42);
+    promise.success(21);
+    promise.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(UniqueFutureTest, overAlignedValue)
+{
+    struct alignas(128) OverAligned
+    {
+        int value = 0;
+    };
+    UniquePromise<OverAligned, std::string> promise;
+    TestUniqueFuture<uintptr_t> future = promise.future().map(
+        [](const OverAligned &x) { return reinterpret_cast<uintptr_t>(&x) % alignof(OverAligned); });
+    promise.success(OverAligned{42});
+    TestFuture<uintptr_t> shared = std::move(future).share();
+    ASSERT_TRUE(shared.isSucceeded());
+    EXPECT_EQ(0, shared.result());
+}
+
+TEST_F(UniqueFutureTest, map)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<std::string> future =
+        promise.future().map([](int x) { return x * 2; }).map([](int x) { return std::to_string(x); }).share();
+    EXPECT_FALSE(future.isCompleted());
+    promise.success(21);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_EQ("42", future.result());
+}
+
+TEST_F(UniqueFutureTest, mapCompleted)
+{
+    TestFuture<int> future = TestUniqueFuture<int>::successful(21).map([](int x) { return x * 2; }).share();
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(UniqueFutureTest, mapMovesValue)
+{
+    TestUniquePromise<std::unique_ptr<int>> promise;
+    TestFuture<int> future = promise.future().map([](std::unique_ptr<int> &&x) { return *x; }).share();
+    promise.success(std::make_unique<int>(42));
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(UniqueFutureTest, mapNoCopies)
+{
+    struct CopyCounter
+    {
+        CopyCounter() = default;
+        CopyCounter(const CopyCounter &other) : copies(other.copies + 1) {}
+        CopyCounter(CopyCounter &&other) noexcept = default;
+        CopyCounter &operator=(const CopyCounter &) = delete;
+        CopyCounter &operator=(CopyCounter &&) noexcept = default;
+        ~CopyCounter() = default;
+        int copies = 0;
+    };
+    UniquePromise<CopyCounter, std::string> promise;
+    TestFuture<int> future = promise.future()
+                                 .map([](CopyCounter &&x) { return std::move(x); })
+                                 .recover([](std::string &&) { return CopyCounter(); })
+                                 .map([](CopyCounter &&x) { return x.copies; })
+                                 .share();
+    promise.success(CopyCounter());
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(0, future.result());
+}
+
+TEST_F(UniqueFutureTest, mapFailed)
+{
+    TestUniquePromise<int> promise;
+    bool called = false;
+    TestFuture<int> future = promise.future()
+                                 .map([&called](int x) {
+                                     called = true;
+                                     return x * 2;
+                                 })
+                                 .share();
+    promise.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+    EXPECT_FALSE(called);
+}
+
+TEST_F(UniqueFutureTest, mapWithFailure)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<int> future = promise.future().map([](int) -> int { return WithTestFailure("failed"); }).share();
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, mapException)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<int> future = promise.future()
+                                 .map([](int) -> int { throw std::runtime_error("Hello World"); })
+                                 .share();
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Hello World", future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, mapFailure)
+{
+    TestUniquePromise<int> promise;
+    Future<int, int> future = promise.future().mapFailure([](std::string &&x) { return (int)x.size(); }).share();
+    promise.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ(6, future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, flatMap)
+{
+    TestUniquePromise<int> promise;
+    TestUniquePromise<std::string> innerPromise;
+    TestFuture<std::string> future = promise.future()
+                                         .flatMap([innerFuture = innerPromise.future()](int) mutable {
+                                             return std::move(innerFuture);
+                                         })
+                                         .share();
+    promise.success(42);
+    EXPECT_FALSE(future.isCompleted());
+    innerPromise.success("done");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ("done", future.result());
+}
+
+TEST_F(UniqueFutureTest, flatMapToFuture)
+{
+    TestUniquePromise<int> promise;
+    TestPromise<std::string> innerPromise;
+    TestFuture<std::string> future =
+        promise.future().flatMap([innerPromise](int) { return innerPromise.future(); }).share();
+    promise.success(42);
+    EXPECT_FALSE(future.isCompleted());
+    innerPromise.success("done");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ("done", future.result());
+}
+
+TEST_F(UniqueFutureTest, flatMapFailed)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<std::string> future =
+        promise.future()
+            .flatMap([](int x) { return TestUniqueFuture<std::string>::failed(std::to_string(x)); })
+            .share();
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("42", future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, andThen)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<std::string> future =
+        promise.future().andThen([]() { return TestUniqueFuture<std::string>::successful("done"); }).share();
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ("done", future.result());
+}
+
+TEST_F(UniqueFutureTest, recover)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<int> future = promise.future().recover([](const std::string &x) { return (int)x.size(); }).share();
+    promise.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_EQ(6, future.result());
+}
+
+TEST_F(UniqueFutureTest, recoverSucceeded)
+{
+    TestUniquePromise<int> promise;
+    TestFuture<int> future = promise.future().recover([](const std::string &) { return 0; }).share();
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(UniqueFutureTest, recoverWith)
+{
+    TestUniquePromise<int> promise;
+    Future<int, int> future =
+        promise.future()
+            .recoverWith([](const std::string &x) { return UniqueFuture<int, int>::failed((int)x.size()); })
+            .share();
+    promise.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ(6, future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, zip)
+{
+    TestUniquePromise<int> firstPromise;
+    TestUniquePromise<double> secondPromise;
+    TestUniquePromise<std::string> thirdPromise;
+    TestFuture<std::tuple<int, double, std::string>> future =
+        firstPromise.future().zip(secondPromise.future(), thirdPromise.future()).share();
+    EXPECT_FALSE(future.isCompleted());
+    secondPromise.success(5.0);
+    EXPECT_FALSE(future.isCompleted());
+    firstPromise.success(42);
+    EXPECT_FALSE(future.isCompleted());
+    thirdPromise.success("Done");
+
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, std::get<0>(future.result()));
+    EXPECT_DOUBLE_EQ(5.0, std::get<1>(future.result()));
+    EXPECT_EQ("Done", std::get<2>(future.result()));
+}
+
+TEST_F(UniqueFutureTest, zipTuples)
+{
+    TestUniquePromise<std::tuple<int, double>> firstPromise;
+    TestUniquePromise<std::string> secondPromise;
+    TestFuture<std::tuple<int, double, std::string>> future = firstPromise.future().zip(secondPromise.future()).share();
+    secondPromise.success("Done");
+    firstPromise.success(std::make_tuple(42, 5.0));
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(42, std::get<0>(future.result()));
+    EXPECT_DOUBLE_EQ(5.0, std::get<1>(future.result()));
+    EXPECT_EQ("Done", std::get<2>(future.result()));
+}
+
+TEST_F(UniqueFutureTest, zipFailed)
+{
+    TestUniquePromise<int> firstPromise;
+    TestUniquePromise<double> secondPromise;
+    TestFuture<std::tuple<int, double>> future = firstPromise.future().zip(secondPromise.future()).share();
+    firstPromise.success(42);
+    secondPromise.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(UniqueFutureTest, zipDifferentFailures)
+{
+    TestUniquePromise<int> firstPromise;
+    UniquePromise<double, int> secondPromise;
+    Future<std::tuple<int, double>, std::variant<std::string, int>> future =
+        firstPromise.future().zip(secondPromise.future()).share();
+    firstPromise.success(42);
+    secondPromise.failure(5);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    ASSERT_EQ(1, future.failureReason().index());
+    EXPECT_EQ(5, std::get<1>(future.failureReason()));
+}
+
+TEST_F(UniqueFutureTest, droppedPromiseReleasesChain)
+{
+    TestFuture<int> future;
+    {
+        TestUniquePromise<int> promise;
+        future = promise.future().map([](int x) { return x; }).share();
+    }
+    EXPECT_FALSE(future.isCompleted());
+}
+
+TEST_F(UniqueFutureTest, multithreadedFill)
+{
+    for (int i = 0; i < 1000; ++i) {
+        TestUniquePromise<int> promise;
+        TestUniqueFuture<int> uniqueFuture = promise.future();
+        std::thread filler([promise = std::move(promise), i]() mutable { promise.success(i); });
+        TestFuture<int> future = std::move(uniqueFuture).map([](int x) { return x + 1; }).share();
+        filler.join();
+        ASSERT_TRUE(future.isCompleted());
+        EXPECT_EQ(i + 1, future.result());
+    }
+}
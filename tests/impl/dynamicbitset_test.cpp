@@ -0,0 +1,93 @@
+#include "asynqro/impl/dynamicbitset_p.h"
+
+#include "gtest/gtest.h"
+
+using namespace asynqro::detail;
+
+TEST(DynamicBitsetTest, empty)
+{
+    DynamicBitset bitset;
+    EXPECT_EQ(0, bitset.size());
+    EXPECT_TRUE(bitset.none());
+    EXPECT_FALSE(bitset.any());
+    EXPECT_FALSE(bitset.test(0));
+    EXPECT_FALSE(bitset.test(1000));
+    EXPECT_EQ(-1, bitset.firstSetBit(0, 1000));
+    EXPECT_EQ(-1, bitset.lastSetBit(DynamicBitset(), 0, 1000));
+    bitset.reset(1000);
+    EXPECT_EQ(0, bitset.size());
+}
+
+TEST(DynamicBitsetTest, setAndReset)
+{
+    DynamicBitset bitset;
+    bitset.set(5);
+    bitset.set(130);
+    EXPECT_EQ(192, bitset.size());
+    EXPECT_EQ(2, bitset.count());
+    EXPECT_TRUE(bitset.test(5));
+    EXPECT_TRUE(bitset.test(130));
+    EXPECT_FALSE(bitset.test(6));
+    bitset.set(5);
+    EXPECT_EQ(2, bitset.count());
+    bitset.reset(5);
+    EXPECT_FALSE(bitset.test(5));
+    EXPECT_EQ(1, bitset.count());
+    bitset.set(130, false);
+    EXPECT_TRUE(bitset.none());
+    bitset.set(1000, false);
+    EXPECT_EQ(192, bitset.size());
+    bitset.reserve(1000);
+    EXPECT_EQ(1024, bitset.size());
+    EXPECT_TRUE(bitset.none());
+}
+
+TEST(DynamicBitsetTest, firstSetBit)
+{
+    DynamicBitset bitset;
+    for (int32_t i : {3, 63, 64, 200, 511})
+        bitset.set(i);
+    EXPECT_EQ(3, bitset.firstSetBit(0, 512));
+    EXPECT_EQ(63, bitset.firstSetBit(4, 512));
+    EXPECT_EQ(64, bitset.firstSetBit(64, 512));
+    EXPECT_EQ(200, bitset.firstSetBit(65, 512));
+    EXPECT_EQ(-1, bitset.firstSetBit(65, 200));
+    EXPECT_EQ(511, bitset.firstSetBit(201, 10000));
+    EXPECT_EQ(-1, bitset.firstSetBit(512, 10000));
+    EXPECT_EQ(-1, bitset.firstSetBit(10, 10));
+}
+
+TEST(DynamicBitsetTest, scansWithExclude)
+{
+    DynamicBitset bitset;
+    DynamicBitset exclude;
+    for (int32_t i = 0; i < 300; i += 2)
+        bitset.set(i);
+    for (int32_t i = 0; i < 250; ++i)
+        exclude.set(i);
+    EXPECT_EQ(250, bitset.firstSetBit(exclude, 0, 300));
+    EXPECT_EQ(298, bitset.lastSetBit(exclude, 0, 300));
+    EXPECT_EQ(296, bitset.lastSetBit(exclude, 0, 298));
+    EXPECT_EQ(-1, bitset.firstSetBit(exclude, 0, 250));
+    EXPECT_EQ(-1, bitset.lastSetBit(exclude, 0, 250));
+    exclude.reset(100);
+    EXPECT_EQ(100, bitset.firstSetBit(exclude, 0, 300));
+    EXPECT_EQ(100, bitset.lastSetBit(exclude, 0, 250));
+    EXPECT_EQ(-1, bitset.lastSetBit(exclude, 101, 250));
+}
+
+TEST(DynamicBitsetTest, bigSizes)
+{
+    DynamicBitset bitset;
+    int32_t n = 4096;
+    for (int32_t i = 0; i < n; ++i)
+        bitset.set(i);
+    EXPECT_EQ(n, bitset.count());
+    for (int32_t i = 0; i < n - 1; ++i) {
+        EXPECT_EQ(i, bitset.firstSetBit(0, n));
+        EXPECT_EQ(n - 1, bitset.lastSetBit(DynamicBitset(), 0, n));
+        bitset.reset(i);
+    }
+    EXPECT_EQ(1, bitset.count());
+    EXPECT_EQ(n - 1, bitset.firstSetBit(0, n));
+}
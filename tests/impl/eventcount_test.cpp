@@ -0,0 +1,103 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include "asynqro/impl/eventcount_p.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace asynqro::detail;
+
+using namespace std::chrono_literals;
+
+TEST(EventCountTest, notifyAfterPrepareIsNotLost)
+{
+    EventCount events;
+    EventCount::Key key = events.prepareWait();
+    events.notify();
+    events.wait(key);
+    SUCCEED();
+}
+
+TEST(EventCountTest, canceledWaitIsNotNotified)
+{
+    EventCount events;
+    EventCount::Key key = events.prepareWait();
+    events.cancelWait(key);
+    events.notify();
+    EXPECT_EQ(key & ~1, events.prepareWait() & ~1);
+}
+
+TEST(EventCountTest, parkedThreadWakesUp)
+{
+    EventCount events;
+    std::atomic_bool condition{false};
+    std::atomic_bool done{false};
+    std::thread thread([&events, &condition, &done]() {
+        while (!condition) {
+            EventCount::Key key = events.prepareWait();
+            if (condition) {
+                events.cancelWait(key);
+                break;
+            }
+            events.wait(key);
+        }
+        done = true;
+    });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(done);
+    condition = true;
+    events.notify();
+    thread.join();
+    EXPECT_TRUE(done);
+}
+
+TEST(EventCountTest, pingPong)
+{
+    const int n = 10000;
+    EventCount events;
+    std::atomic_int counter{0};
+    std::thread consumer([&events, &counter]() {
+        int expected = 0;
+        while (expected < n) {
+            if (counter.load() > expected) {
+                ++expected;
+                continue;
+            }
+            EventCount::Key key = events.prepareWait();
+            if (counter.load() > expected) {
+                events.cancelWait(key);
+                continue;
+            }
+            events.wait(key);
+        }
+    });
+    for (int i = 0; i < n; ++i) {
+        counter.fetch_add(1);
+        events.notify();
+    }
+    consumer.join();
+    EXPECT_EQ(n, counter);
+}
@@ -0,0 +1,72 @@
+#include "asynqro/impl/memorypool.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+
+using namespace asynqro::detail;
+
+TEST(MemoryPoolTest, reuse)
+{
+    void *first = allocateFromPool(100);
+    ASSERT_NE(nullptr, first);
+    deallocateToPool(first, 100);
+    void *second = allocateFromPool(100);
+    EXPECT_EQ(first, second);
+    deallocateToPool(second, 100);
+}
+
+TEST(MemoryPoolTest, reuseSameSizeClass)
+{
+    void *first = allocateFromPool(70);
+    deallocateToPool(first, 70);
+    void *second = allocateFromPool(128);
+    EXPECT_EQ(first, second);
+    deallocateToPool(second, 128);
+}
+
+TEST(MemoryPoolTest, differentSizeClasses)
+{
+    void *first = allocateFromPool(64);
+    deallocateToPool(first, 64);
+    void *second = allocateFromPool(65);
+    EXPECT_NE(first, second);
+    deallocateToPool(second, 65);
+    void *third = allocateFromPool(1);
+    EXPECT_EQ(first, third);
+    deallocateToPool(third, 1);
+}
+
+TEST(MemoryPoolTest, hugeAllocation)
+{
+    void *first = allocateFromPool(1024 * 1024);
+    ASSERT_NE(nullptr, first);
+    static_cast<char *>(first)[1024 * 1024 - 1] = 42;
+    deallocateToPool(first, 1024 * 1024);
+}
+
+TEST(MemoryPoolTest, deallocateInOtherThread)
+{
+    void *first = allocateFromPool(200);
+    void *reused = nullptr;
+    std::thread([first, &reused]() {
+        deallocateToPool(first, 200);
+        reused = allocateFromPool(200);
+        deallocateToPool(reused, 200);
+    }).join();
+    EXPECT_EQ(first, reused);
+}
+
+TEST(MemoryPoolTest, counters)
+{
+    int_fast64_t pooledBefore = asynqro::instantPooledAllocations();
+    int_fast64_t nonPooledBefore = asynqro::instantNonPooledAllocations();
+    void *first = allocateFromPoolCounted(300);
+    deallocateToPool(first, 300);
+    void *second = allocateFromPoolCounted(300);
+    deallocateToPool(second, 300);
+    void *third = allocateFromPoolCounted(1024 * 1024);
+    deallocateToPool(third, 1024 * 1024);
+    EXPECT_LE(1, asynqro::instantPooledAllocations() - pooledBefore);
+    EXPECT_LE(1, asynqro::instantNonPooledAllocations() - nonPooledBefore);
+}
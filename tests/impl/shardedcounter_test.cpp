@@ -0,0 +1,66 @@
+/* Copyright 2019, Denis Kormalev
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without modification, are permitted
+ * provided that the following conditions are met:
+ *
+ *     * Redistributions of source code must retain the above copyright notice, this list of
+ * conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright notice, this list of
+ * conditions and the following disclaimer in the documentation and/or other materials provided
+ * with the distribution.
+ *     * Neither the name of the copyright holders nor the names of its contributors may be used to
+ * endorse or promote products derived from this software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS IS" AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND
+ * FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER OR
+ * CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL
+ * DAMAGES (INCLUDING, BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF LIABILITY, WHETHER
+ * IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT
+ * OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ */
+#include "asynqro/impl/shardedcounter_p.h"
+
+#include "gtest/gtest.h"
+
+#include <thread>
+#include <vector>
+
+using namespace asynqro::detail;
+
+TEST(ShardedCounterTest, singleThread)
+{
+    ShardedCounter counter;
+    EXPECT_EQ(0, counter.load());
+    counter.add(5);
+    counter.sub(2);
+    EXPECT_EQ(3, counter.load());
+}
+
+TEST(ShardedCounterTest, changedFromDifferentThreads)
+{
+    ShardedCounter counter;
+    const int threadsCount = 8;
+    const int n = 10000;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadsCount; ++i) {
+        threads.emplace_back([&counter]() {
+            for (int j = 0; j < n; ++j)
+                counter.add(2);
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(threadsCount * n * 2, counter.load());
+}
+
+TEST(ShardedCounterTest, decrementedInOtherThread)
+{
+    ShardedCounter counter;
+    counter.add(10);
+    std::thread([&counter]() { counter.sub(10); }).join();
+    EXPECT_EQ(0, counter.load());
+}
@@ -2,6 +2,8 @@
 
 #include "gtest/gtest.h"
 
+#include <vector>
+
 using namespace asynqro::detail;
 
 using namespace std::chrono_literals;
@@ -106,3 +108,109 @@ TEST(SpinLockTest, holderScoped)
     }
     EXPECT_TRUE(lock.tryLock());
 }
+
+TEST(SpinLockTest, contendedLock)
+{
+    SpinLock lock;
+    const int threadsCount = 4;
+    const int n = 20000;
+    int counter = 0;
+    std::vector<std::thread> threads;
+    for (int i = 0; i < threadsCount; ++i) {
+        threads.emplace_back([&lock, &counter]() {
+            for (int j = 0; j < n; ++j) {
+                SpinLockHolder holder(&lock);
+                ++counter;
+            }
+        });
+    }
+    for (auto &thread : threads)
+        thread.join();
+    EXPECT_EQ(threadsCount * n, counter);
+    EXPECT_TRUE(lock.tryLock());
+}
+
+TEST(SpinLockTest, handOffToParked)
+{
+    SpinLock lock;
+    std::atomic_bool done{false};
+    lock.lock();
+    std::thread thread([&lock, &done]() {
+        lock.lock();
+        done = true;
+        lock.unlock();
+    });
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(done);
+    auto start = std::chrono::steady_clock::now();
+    lock.unlock();
+    thread.join();
+    EXPECT_TRUE(done);
+    EXPECT_LT(std::chrono::steady_clock::now() - start, 5s);
+    EXPECT_TRUE(lock.tryLock());
+}
+
+TEST(SpinLockTest, holderAbandonedWhileParked)
+{
+    SpinLock lock;
+    std::atomic_bool abandon{false};
+    std::atomic_bool locked{true};
+    lock.lock();
+    std::thread thread([&lock, &abandon, &locked]() {
+        SpinLockHolder holder(&lock, abandon);
+        locked = holder.isLocked();
+    });
+    std::this_thread::sleep_for(50ms);
+    abandon = true;
+    thread.join();
+    EXPECT_FALSE(locked);
+    lock.unlock();
+    EXPECT_TRUE(lock.tryLock());
+}
+
+TEST(SpinLockTest, abandonedWaiterDoesntBlockOthers)
+{
+    SpinLock lock;
+    std::atomic_bool abandon{false};
+    std::atomic_bool done{false};
+    lock.lock();
+    std::thread abandoning([&lock, &abandon]() { SpinLockHolder holder(&lock, abandon); });
+    std::thread waiting([&lock, &done]() {
+        SpinLockHolder holder(&lock);
+        done = true;
+    });
+    std::this_thread::sleep_for(50ms);
+    lock.unlock();
+    abandon = true;
+    abandoning.join();
+    waiting.join();
+    EXPECT_TRUE(done);
+    EXPECT_TRUE(lock.tryLock());
+}
+
+#ifdef ASYNQRO_SPINLOCK_STATS
+TEST(SpinLockTest, stats)
+{
+    SpinLock lock;
+    lock.lock();
+    lock.unlock();
+    SpinLockStats stats = lock.stats();
+    EXPECT_EQ(1, stats.acquisitions);
+    EXPECT_EQ(0, stats.contendedAcquisitions);
+    EXPECT_EQ(0, stats.parkedAcquisitions);
+
+    lock.lock();
+    std::thread thread([&lock]() {
+        lock.lock();
+        lock.unlock();
+    });
+    std::this_thread::sleep_for(50ms);
+    lock.unlock();
+    thread.join();
+    stats = lock.stats();
+    EXPECT_EQ(3, stats.acquisitions);
+    EXPECT_EQ(1, stats.contendedAcquisitions);
+    EXPECT_EQ(1, stats.parkedAcquisitions);
+    EXPECT_GT(stats.parkTime.count(), 0);
+}
+#endif
@@ -246,3 +246,211 @@ TEST(TasksListTest, iteratorIncrementOverGaps)
     EXPECT_FALSE(it->isValid());
     EXPECT_EQ(&TaskInfo::empty(), &*it);
 }
+
+TEST(TasksListTest, allPriorities)
+{
+    TasksList list;
+    std::vector<int> result;
+    for (int i = 255; i >= 0; --i)
+        list.insert([&result, i]() { result.push_back(i); }, TaskType::Custom, 0, static_cast<TaskPriority>(i));
+    EXPECT_EQ(256, list.size());
+    for (const auto &taskInfo : list)
+        taskInfo.task();
+    ASSERT_EQ(256, result.size());
+    for (int i = 0; i < 256; ++i)
+        EXPECT_EQ(i, result[static_cast<size_t>(i)]);
+}
+
+TEST(TasksListTest, manySegmentsWithGaps)
+{
+    int n = 1000;
+    TasksList list;
+    for (int i = 0; i < n; ++i)
+        list.insert([]() {}, TaskType::Custom, i, TaskPriority::Regular);
+
+    for (auto it = list.begin(); it != list.end();) {
+        if (it->tag % 3)
+            it = list.erase(it);
+        else
+            ++it;
+    }
+    EXPECT_EQ((n + 2) / 3, list.size());
+    int expected = 0;
+    for (const auto &taskInfo : list) {
+        EXPECT_EQ(expected, taskInfo.tag);
+        expected += 3;
+    }
+    EXPECT_EQ(n + 2, expected);
+
+    std::vector<int> expectedTags;
+    for (int i = 0; i < n; i += 3)
+        expectedTags.push_back(i);
+    for (int i = 0; i < n; ++i) {
+        list.insert([]() {}, TaskType::Custom, n + i, TaskPriority::Regular);
+        expectedTags.push_back(n + i);
+    }
+    std::vector<int> tags;
+    while (!list.empty()) {
+        auto it = list.begin();
+        tags.push_back(it->tag);
+        list.erase(it);
+    }
+    EXPECT_EQ(expectedTags, tags);
+    EXPECT_EQ(list.end(), list.begin());
+}
+
+TEST(TasksListTest, sharedSegmentsCache)
+{
+    int n = 200;
+    TasksList::SegmentsCache cache(2);
+    TasksList first(&cache);
+    TasksList second(&cache);
+    for (int round = 0; round < 3; ++round) {
+        for (int i = 0; i < n; ++i) {
+            first.insert([]() {}, TaskType::Custom, i, TaskPriority::Regular);
+            second.insert([]() {}, TaskType::Custom, n + i, TaskPriority::Regular);
+        }
+        EXPECT_EQ(n, first.size());
+        EXPECT_EQ(n, second.size());
+        for (int i = 0; i < n; ++i) {
+            EXPECT_EQ(i, first.begin()->tag);
+            first.erase(first.begin());
+            EXPECT_EQ(n + i, second.begin()->tag);
+            second.erase(second.begin());
+        }
+        EXPECT_TRUE(first.empty());
+        EXPECT_TRUE(second.empty());
+    }
+}
+
+TEST(TasksQueueTest, readyOrder)
+{
+    TasksQueue queue;
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 1, TaskPriority::Regular));
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 2, TaskPriority::Regular));
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 1, TaskPriority::Regular));
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 3, TaskPriority::Emergency));
+    queue.insert(TaskInfo([]() {}, TaskType::Intensive, 0, TaskPriority::Background));
+    EXPECT_EQ(5, queue.size());
+
+    std::vector<int32_t> tags;
+    while (auto ready = queue.firstReady())
+        tags.push_back(queue.takeFront(ready->poolInfo).tag);
+    EXPECT_EQ((std::vector<int32_t>{3, 1, 2, 1, 0}), tags);
+    EXPECT_TRUE(queue.empty());
+    EXPECT_FALSE(queue.firstReady());
+}
+
+TEST(TasksQueueTest, nextReadyRevisitsSubPool)
+{
+    TasksQueue queue;
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 1, TaskPriority::Regular));
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 2, TaskPriority::Regular));
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 1, TaskPriority::Regular));
+
+    std::vector<int32_t> tags;
+    for (auto ready = queue.firstReady(); ready; ready = queue.nextReady(*ready))
+        tags.push_back(queue.takeFront(ready->poolInfo).tag);
+    EXPECT_EQ((std::vector<int32_t>{1, 2, 1}), tags);
+    EXPECT_TRUE(queue.empty());
+}
+
+TEST(TasksQueueTest, blockedSubPools)
+{
+    TasksQueue queue;
+    uint64_t blockedPool = packPoolInfo(TaskType::Custom, 1);
+    queue.setBlocked(blockedPool, true);
+    for (int i = 0; i < 100; ++i)
+        queue.insert(TaskInfo([]() {}, TaskType::Custom, 1, TaskPriority::Emergency));
+    EXPECT_EQ(100, queue.size());
+    EXPECT_FALSE(queue.firstReady());
+
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 2, TaskPriority::Regular));
+    auto ready = queue.firstReady();
+    ASSERT_TRUE(ready);
+    EXPECT_EQ(packPoolInfo(TaskType::Custom, 2), ready->poolInfo);
+    EXPECT_FALSE(queue.nextReady(*ready));
+
+    queue.setBlocked(blockedPool, false);
+    ready = queue.firstReady();
+    ASSERT_TRUE(ready);
+    EXPECT_EQ(blockedPool, ready->poolInfo);
+    EXPECT_EQ(1, queue.front(blockedPool).tag);
+
+    queue.setBlocked(blockedPool, true);
+    ready = queue.firstReady();
+    ASSERT_TRUE(ready);
+    EXPECT_EQ(packPoolInfo(TaskType::Custom, 2), ready->poolInfo);
+    queue.takeFront(ready->poolInfo);
+    EXPECT_FALSE(queue.firstReady());
+    EXPECT_EQ(100, queue.size());
+}
+
+TEST(TasksQueueTest, emptySubPoolsAreErased)
+{
+    TasksQueue queue;
+    for (int32_t tag = 1; tag <= 100; ++tag) {
+        queue.insert(TaskInfo([]() {}, TaskType::Custom, tag, TaskPriority::Regular));
+        auto ready = queue.firstReady();
+        ASSERT_TRUE(ready);
+        queue.takeFront(ready->poolInfo);
+    }
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(0, queue.subPoolsCount());
+
+    uint64_t blockedPool = packPoolInfo(TaskType::Custom, 1);
+    queue.setBlocked(blockedPool, true);
+    EXPECT_EQ(1, queue.subPoolsCount());
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 1, TaskPriority::Regular));
+    queue.takeFront(blockedPool);
+    EXPECT_EQ(1, queue.subPoolsCount());
+    queue.setBlocked(blockedPool, false);
+    EXPECT_EQ(0, queue.subPoolsCount());
+}
+
+TEST(TasksQueueTest, defaultSubPoolsAreKept)
+{
+    TasksQueue queue;
+    for (int i = 0; i < 100; ++i) {
+        queue.insert(TaskInfo([]() {}, TaskType::Custom, 0, TaskPriority::Regular));
+        queue.insert(TaskInfo([]() {}, TaskType::Intensive, 0, TaskPriority::Regular));
+        while (auto ready = queue.firstReady())
+            queue.takeFront(ready->poolInfo);
+        EXPECT_TRUE(queue.empty());
+        EXPECT_EQ(2, queue.subPoolsCount());
+    }
+
+    uint64_t customPool = packPoolInfo(TaskType::Custom, 0);
+    queue.setBlocked(customPool, true);
+    queue.setBlocked(customPool, false);
+    EXPECT_EQ(2, queue.subPoolsCount());
+    queue.insert(TaskInfo([]() {}, TaskType::Custom, 0, TaskPriority::Regular));
+    auto ready = queue.firstReady();
+    ASSERT_TRUE(ready);
+    EXPECT_EQ(customPool, ready->poolInfo);
+}
+
+TEST(TasksQueueTest, reusedSubPoolsKeepOrder)
+{
+    TasksQueue queue;
+    for (int round = 0; round < 10; ++round) {
+        for (int32_t tag = 1; tag <= 10; ++tag)
+            queue.insert(TaskInfo([]() {}, TaskType::Custom, tag, TaskPriority::Regular));
+        std::vector<int32_t> tags;
+        while (auto ready = queue.firstReady())
+            tags.push_back(queue.takeFront(ready->poolInfo).tag);
+        EXPECT_EQ((std::vector<int32_t>{1, 2, 3, 4, 5, 6, 7, 8, 9, 10}), tags);
+        EXPECT_EQ(0, queue.subPoolsCount());
+    }
+}
+
+TEST(TasksQueueTest, invalidTasksAreIgnored)
+{
+    TasksQueue queue;
+    queue.insert(TaskInfo());
+    queue.insert(TaskInfo(nullptr, TaskType::Custom, 1, TaskPriority::Regular));
+    EXPECT_TRUE(queue.empty());
+    EXPECT_EQ(0, queue.size());
+    EXPECT_EQ(0, queue.subPoolsCount());
+    EXPECT_FALSE(queue.firstReady());
+}
@@ -0,0 +1,108 @@
+#include "asynqro/impl/uniquefunction.h"
+
+#include "gtest/gtest.h"
+
+#include <array>
+#include <memory>
+
+using namespace asynqro::detail;
+
+namespace {
+struct InstancesCounter
+{
+    explicit InstancesCounter(int *counter) : counter(counter) { ++(*counter); }
+    InstancesCounter(const InstancesCounter &other) : counter(other.counter) { ++(*counter); }
+    InstancesCounter(InstancesCounter &&other) noexcept : counter(other.counter) { ++(*counter); }
+    InstancesCounter &operator=(const InstancesCounter &) = delete;
+    InstancesCounter &operator=(InstancesCounter &&) = delete;
+    ~InstancesCounter() { --(*counter); }
+    int *counter;
+};
+} // namespace
+
+TEST(UniqueFunctionTest, empty)
+{
+    UniqueFunction<void()> f;
+    EXPECT_FALSE(f);
+    UniqueFunction<void()> g = nullptr;
+    EXPECT_FALSE(g);
+}
+
+TEST(UniqueFunctionTest, call)
+{
+    UniqueFunction<int(int)> f = [](int x) { return x * 2; };
+    ASSERT_TRUE(f);
+    EXPECT_EQ(42, f(21));
+}
+
+TEST(UniqueFunctionTest, mutableState)
+{
+    UniqueFunction<int()> f = [x = 0]() mutable { return ++x; };
+    EXPECT_EQ(1, f());
+    EXPECT_EQ(2, f());
+    EXPECT_EQ(3, f());
+}
+
+TEST(UniqueFunctionTest, moveOnlyCapture)
+{
+    auto value = std::make_unique<int>(42);
+    UniqueFunction<int()> f = [value = std::move(value)]() { return *value; };
+    EXPECT_EQ(42, f());
+}
+
+TEST(UniqueFunctionTest, smallIsInline)
+{
+    auto small = [x = 5]() { return x; };
+    EXPECT_TRUE(UniqueFunction<int()>::storesInline<decltype(small)>());
+    std::array<char, 128> bigArray = {};
+    auto big = [bigArray]() { return static_cast<int>(bigArray[0]); };
+    EXPECT_FALSE(UniqueFunction<int()>::storesInline<decltype(big)>());
+    EXPECT_TRUE((UniqueFunction<int(), 256>::storesInline<decltype(big)>()));
+}
+
+TEST(UniqueFunctionTest, move)
+{
+    int counter = 0;
+    {
+        UniqueFunction<int()> f = [c = InstancesCounter(&counter)]() { return *c.counter; };
+        EXPECT_EQ(1, counter);
+        UniqueFunction<int()> g = std::move(f);
+        EXPECT_FALSE(f); // NOLINT(bugprone-use-after-move)
+        ASSERT_TRUE(g);
+        EXPECT_EQ(1, counter);
+        EXPECT_EQ(1, g());
+        f = std::move(g);
+        EXPECT_FALSE(g); // NOLINT(bugprone-use-after-move)
+        ASSERT_TRUE(f);
+        EXPECT_EQ(1, counter);
+    }
+    EXPECT_EQ(0, counter);
+}
+
+TEST(UniqueFunctionTest, moveHeap)
+{
+    int counter = 0;
+    {
+        std::array<char, 128> bigArray = {};
+        UniqueFunction<int()> f = [c = InstancesCounter(&counter), bigArray]() {
+            return *c.counter + bigArray[0];
+        };
+        EXPECT_EQ(1, counter);
+        UniqueFunction<int()> g = std::move(f);
+        EXPECT_FALSE(f); // NOLINT(bugprone-use-after-move)
+        ASSERT_TRUE(g);
+        EXPECT_EQ(1, counter);
+        EXPECT_EQ(1, g());
+    }
+    EXPECT_EQ(0, counter);
+}
+
+TEST(UniqueFunctionTest, reset)
+{
+    int counter = 0;
+    UniqueFunction<int()> f = [c = InstancesCounter(&counter)]() { return *c.counter; };
+    EXPECT_EQ(1, counter);
+    f = nullptr;
+    EXPECT_FALSE(f);
+    EXPECT_EQ(0, counter);
+}
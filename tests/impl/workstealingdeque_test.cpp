@@ -0,0 +1,108 @@
+#include "asynqro/impl/workstealingdeque_p.h"
+
+#include "gtest/gtest.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace asynqro::tasks::detail;
+
+TEST(WorkStealingDequeTest, empty)
+{
+    WorkStealingDeque<int> deque;
+    EXPECT_TRUE(deque.empty());
+    EXPECT_EQ(nullptr, deque.pop());
+    EXPECT_EQ(nullptr, deque.steal());
+}
+
+TEST(WorkStealingDequeTest, popIsLifo)
+{
+    std::vector<int> values = {1, 2, 3, 4, 5};
+    WorkStealingDeque<int> deque;
+    for (auto &x : values)
+        deque.push(&x);
+    EXPECT_FALSE(deque.empty());
+    for (auto it = values.rbegin(); it != values.rend(); ++it)
+        EXPECT_EQ(&*it, deque.pop());
+    EXPECT_TRUE(deque.empty());
+    EXPECT_EQ(nullptr, deque.pop());
+}
+
+TEST(WorkStealingDequeTest, stealIsFifo)
+{
+    std::vector<int> values = {1, 2, 3, 4, 5};
+    WorkStealingDeque<int> deque;
+    for (auto &x : values)
+        deque.push(&x);
+    for (auto &x : values)
+        EXPECT_EQ(&x, deque.steal());
+    EXPECT_TRUE(deque.empty());
+    EXPECT_EQ(nullptr, deque.steal());
+}
+
+TEST(WorkStealingDequeTest, mixedEnds)
+{
+    std::vector<int> values = {1, 2, 3, 4};
+    WorkStealingDeque<int> deque;
+    for (auto &x : values)
+        deque.push(&x);
+    EXPECT_EQ(&values[0], deque.steal());
+    EXPECT_EQ(&values[3], deque.pop());
+    EXPECT_EQ(&values[1], deque.steal());
+    EXPECT_EQ(&values[2], deque.pop());
+    EXPECT_EQ(nullptr, deque.pop());
+    EXPECT_EQ(nullptr, deque.steal());
+}
+
+TEST(WorkStealingDequeTest, growth)
+{
+    std::vector<int> values(1000);
+    WorkStealingDeque<int> deque(2);
+    for (auto &x : values)
+        deque.push(&x);
+    for (auto it = values.rbegin(); it != values.rend(); ++it)
+        EXPECT_EQ(&*it, deque.pop());
+    EXPECT_TRUE(deque.empty());
+}
+
+TEST(WorkStealingDequeTest, concurrentSteal)
+{
+    const int n = 100000;
+    const int thievesCount = 4;
+    std::vector<int> values(n, 0);
+    WorkStealingDeque<int> deque(4);
+    std::atomic_bool done{false};
+    std::atomic_int taken{0};
+    std::vector<std::thread> thieves;
+    for (int i = 0; i < thievesCount; ++i) {
+        thieves.emplace_back([&deque, &done, &taken]() {
+            while (!done) {
+                if (int *x = deque.steal()) {
+                    ++*x;
+                    ++taken;
+                }
+            }
+        });
+    }
+    for (int i = 0; i < n; ++i) {
+        deque.push(&values[static_cast<size_t>(i)]);
+        if (i % 3 == 0) {
+            if (int *x = deque.pop()) {
+                ++*x;
+                ++taken;
+            }
+        }
+    }
+    for (int *x = deque.pop(); x; x = deque.pop()) {
+        ++*x;
+        ++taken;
+    }
+    EXPECT_TRUE(deque.empty());
+    done = true;
+    for (auto &thief : thieves)
+        thief.join();
+    EXPECT_EQ(n, taken);
+    for (int i = 0; i < n; ++i)
+        EXPECT_EQ(1, values[static_cast<size_t>(i)]) << i;
+}
@@ -6,7 +6,6 @@ using namespace asynqro::repeater;
 class RepeatTest : public TasksBaseTest
 {};
 
-using RepeatDeathTest = RepeatTest;
 using RepeatedDataResult = RepeaterResult<std::vector<int>, int, std::vector<int>>;
 using RepeatedFutureResult = RepeaterFutureResult<int, std::string, int>;
 
@@ -386,24 +385,22 @@ TEST_F(RepeatTest, repeatDataDeepNoTrampoline)
     EXPECT_EQ(DEEP_RECURSION_LIMIT * 10, f.result());
 }
 
-TEST_F(RepeatDeathTest, repeatFutureDeepNoTrampoline)
+TEST_F(RepeatTest, repeatFutureDeepNoTrampoline)
 {
-#ifndef ASYNQRO_GCOV_ENABLED
-    testing::FLAGS_gtest_death_test_style = "threadsafe";
-    auto death = []() {
-        TestPromise<RepeatedFutureResult::Value> promise;
-        TestFuture<int> f = repeat<int, std::string>(
-            [promise](int step) -> RepeatedFutureResult {
-                if (step >= DEEP_RECURSION_LIMIT)
-                    return promise.future();
-                return tasks::run([step]() -> RepeaterResult<int, int> { return Continue(step + 1); });
-            },
-            0);
-        promise.success(42);
-        f.wait();
-    };
-    ASSERT_DEATH(death(), ".*");
-#endif
+    TestPromise<RepeatedFutureResult::Value> promise;
+    TestFuture<int> f = repeat<int, std::string>(
+        [promise](int step) -> RepeatedFutureResult {
+            if (step >= DEEP_RECURSION_LIMIT)
+                return promise.future();
+            return tasks::run([step]() -> RepeaterResult<int, int> { return Continue(step + 1); });
+        },
+        0);
+    ASSERT_FALSE(f.isCompleted());
+    promise.success(42);
+    f.wait();
+    ASSERT_TRUE(f.isCompleted());
+    ASSERT_TRUE(f.isSucceeded());
+    EXPECT_EQ(42, f.result());
 }
 
 TEST_F(RepeatTest, repeatFutureDeepWithOccasionalTrampoline)
@@ -0,0 +1,227 @@
+#include "tasksbasetest.h"
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+class TasksAlgorithmsTest : public TasksBaseTest
+{};
+
+namespace {
+std::vector<int> randomData(int n, int maxValue)
+{
+    std::mt19937 generator(42);
+    std::uniform_int_distribution<int> distribution(0, maxValue);
+    std::vector<int> result;
+    for (int i = 0; i < n; ++i)
+        result.push_back(distribution(generator));
+    return result;
+}
+} // namespace
+
+TEST_F(TasksAlgorithmsTest, sort)
+{
+    for (int maxValue : {1, 10, 1000000}) {
+        std::vector<int> input = randomData(10000, maxValue);
+        std::vector<int> expected = input;
+        std::sort(expected.begin(), expected.end());
+        TestFuture<std::vector<int>> future = algorithms::sort(input);
+        future.wait(10000);
+        ASSERT_TRUE(future.isCompleted()) << maxValue;
+        ASSERT_TRUE(future.isSucceeded()) << maxValue;
+        EXPECT_EQ(expected, future.result()) << maxValue;
+    }
+}
+
+TEST_F(TasksAlgorithmsTest, sortWithComparator)
+{
+    std::vector<int> input = randomData(5000, 1000);
+    std::vector<int> expected = input;
+    std::sort(expected.begin(), expected.end(), std::greater<>());
+    TestFuture<std::vector<int>> future = algorithms::sort(input, std::greater<>(), 100, TaskType::Custom);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(expected, future.result());
+}
+
+TEST_F(TasksAlgorithmsTest, sortSmall)
+{
+    TestFuture<std::vector<int>> future = algorithms::sort(std::vector<int>());
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.result().empty());
+    future = algorithms::sort(std::vector<int>{3, 1, 2});
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(std::vector<int>({1, 2, 3}), future.result());
+}
+
+TEST_F(TasksAlgorithmsTest, sortWithException)
+{
+    std::vector<int> input = randomData(1000, 1000);
+    TestFuture<std::vector<int>> future = algorithms::sort(input, [](int a, int b) -> bool {
+        if (a == b)
+            throw std::runtime_error("Hi");
+        return a < b;
+    });
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Hi", future.failureReason());
+}
+
+TEST_F(TasksAlgorithmsTest, inclusiveScan)
+{
+    for (int n : {1, 2, 17, 10000}) {
+        std::vector<int> input = randomData(n, 100);
+        std::vector<int> expected(input.size());
+        std::partial_sum(input.begin(), input.end(), expected.begin());
+        TestFuture<std::vector<int>> future = algorithms::inclusiveScan(input);
+        future.wait(10000);
+        ASSERT_TRUE(future.isCompleted()) << n;
+        ASSERT_TRUE(future.isSucceeded()) << n;
+        EXPECT_EQ(expected, future.result()) << n;
+    }
+}
+
+TEST_F(TasksAlgorithmsTest, inclusiveScanKeepsOrder)
+{
+    std::vector<std::string> input;
+    std::vector<std::string> expected;
+    for (int i = 0; i < 500; ++i) {
+        input.push_back(std::to_string(i % 10));
+        expected.push_back((expected.empty() ? "" : expected.back()) + input.back());
+    }
+    TestFuture<std::vector<std::string>> future = algorithms::inclusiveScan(input, std::plus<>(), 7, TaskType::Custom);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(expected, future.result());
+}
+
+TEST_F(TasksAlgorithmsTest, exclusiveScan)
+{
+    for (int n : {1, 2, 17, 10000}) {
+        std::vector<int> input = randomData(n, 100);
+        std::vector<int> expected;
+        int sum = 5;
+        for (int x : input) {
+            expected.push_back(sum);
+            sum += x;
+        }
+        TestFuture<std::vector<int>> future = algorithms::exclusiveScan(input, 5);
+        future.wait(10000);
+        ASSERT_TRUE(future.isCompleted()) << n;
+        ASSERT_TRUE(future.isSucceeded()) << n;
+        EXPECT_EQ(expected, future.result()) << n;
+    }
+}
+
+TEST_F(TasksAlgorithmsTest, scanWithFailure)
+{
+    std::vector<int> input = randomData(1000, 100);
+    TestFuture<std::vector<int>> future = algorithms::inclusiveScan(input, [](int a, int b) -> int {
+        if (a > 10000)
+            return WithTestFailure("failed");
+        return a + b;
+    });
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(TasksAlgorithmsTest, partition)
+{
+    std::vector<int> input = randomData(10000, 1000);
+    std::vector<int> expectedSelected;
+    std::vector<int> expectedRejected;
+    std::partition_copy(input.begin(), input.end(), std::back_inserter(expectedSelected),
+                        std::back_inserter(expectedRejected), [](int x) { return x % 3 == 0; });
+    TestFuture<std::pair<std::vector<int>, std::vector<int>>> future =
+        algorithms::partition(input, [](int x) { return x % 3 == 0; }, 10);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(expectedSelected, future.result().first);
+    EXPECT_EQ(expectedRejected, future.result().second);
+}
+
+TEST_F(TasksAlgorithmsTest, copyIf)
+{
+    std::vector<int> input = randomData(10000, 1000);
+    std::vector<int> expected;
+    std::copy_if(input.begin(), input.end(), std::back_inserter(expected), [](int x) { return x > 900; });
+    std::atomic_int calls{0};
+    TestFuture<std::vector<int>> future = algorithms::copyIf(input, [&calls](int x) {
+        ++calls;
+        return x > 900;
+    });
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(expected, future.result());
+    EXPECT_EQ(10000, calls);
+}
+
+TEST_F(TasksAlgorithmsTest, copyIfWithFailure)
+{
+    std::vector<int> input = randomData(1000, 1000);
+    input[500] = -1;
+    TestFuture<std::vector<int>> future = algorithms::copyIf(input, [](int x) -> bool {
+        if (x < 0)
+            return WithTestFailure("failed");
+        return x > 500;
+    });
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(TasksAlgorithmsTest, emptyCopyIfAndPartition)
+{
+    TestFuture<std::vector<int>> copied = algorithms::copyIf(std::vector<int>(), [](int) { return true; });
+    ASSERT_TRUE(copied.isCompleted());
+    EXPECT_TRUE(copied.result().empty());
+    TestFuture<std::pair<std::vector<int>, std::vector<int>>> partitioned =
+        algorithms::partition(std::vector<int>(), [](int) { return true; });
+    ASSERT_TRUE(partitioned.isCompleted());
+    EXPECT_TRUE(partitioned.result().first.empty());
+    EXPECT_TRUE(partitioned.result().second.empty());
+}
+
+TEST_F(TasksAlgorithmsTest, transformReduce)
+{
+    std::vector<int> input = randomData(10000, 1000);
+    long long expected = 0;
+    for (int x : input)
+        expected += static_cast<long long>(x) * 2;
+    TestFuture<long long> future = algorithms::transformReduce(
+        input, 0ll, [](long long a, long long b) { return a + b; }, [](int x) { return x * 2ll; });
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(expected, future.result());
+}
+
+TEST_F(TasksAlgorithmsTest, algorithmsRespectSubPoolCapacity)
+{
+    TasksDispatcher::instance()->addCustomTag(76, 2);
+    std::atomic_int running{0};
+    std::atomic_int maxRunning{0};
+    auto predicate = [&running, &maxRunning](int x) {
+        int current = ++running;
+        int max = maxRunning;
+        while (current > max && !maxRunning.compare_exchange_weak(max, current))
+            ;
+        std::this_thread::sleep_for(10us);
+        --running;
+        return x % 2 == 0;
+    };
+    TestFuture<std::vector<int>> future = algorithms::copyIf(randomData(2000, 100), predicate, 1, TaskType::Custom, 76);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_GE(2, maxRunning);
+}
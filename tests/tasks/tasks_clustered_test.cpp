@@ -195,3 +195,259 @@ TEST_F(TasksClusteredRunTest, clusteredRunWithNegativeClusterSize)
     EXPECT_EQ("failed", future.failureReason());
     EXPECT_EQ(0, future.result().size());
 }
+
+TEST_F(TasksClusteredRunTest, clusteredRunWithSlowElement)
+{
+    std::atomic_int processedCount{0};
+    std::atomic_int processedWhileBlocked{-1};
+    std::vector<int> input;
+
+    int capacity = 4;
+    TasksDispatcher::instance()->addCustomTag(75, capacity);
+    int n = 800;
+    // With static clusters only 3/4 of elements could be processed while first element blocks its cluster
+    int expectedWhileBlocked = n - n / (2 * capacity);
+    for (int i = 0; i < n; ++i)
+        input.push_back(i);
+    TestFuture<std::vector<int>> future = clusteredRun(
+        input,
+        [&processedCount, &processedWhileBlocked, expectedWhileBlocked](int x) {
+            if (!x) {
+                auto timeout = std::chrono::high_resolution_clock::now() + 10s;
+                while (processedCount < expectedWhileBlocked && std::chrono::high_resolution_clock::now() < timeout)
+                    std::this_thread::sleep_for(1ms);
+                processedWhileBlocked = processedCount.load();
+            }
+            ++processedCount;
+            return x * 2;
+        },
+        1, TaskType::Custom, 75);
+    future.wait(30000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(n, processedCount);
+    EXPECT_LE(expectedWhileBlocked, processedWhileBlocked);
+    auto result = future.result();
+    ASSERT_EQ(n, result.size());
+    for (int i = 0; i < n; ++i)
+        EXPECT_EQ(i * 2, result[i]);
+}
+
+TEST_F(TasksClusteredRunTest, chunksCursorWithHugeRange)
+{
+    const int64_t amount = 5'000'000'000ll;
+    const int64_t minChunkSize = 1ll << 28;
+    tasks::detail::ChunksCursor cursor(amount, minChunkSize, 4);
+    int64_t expectedBegin = 0;
+    int64_t begin = 0;
+    int64_t end = 0;
+    int64_t previousSize = amount;
+    while (cursor.next(begin, end)) {
+        EXPECT_EQ(expectedBegin, begin);
+        EXPECT_LT(begin, end);
+        if (end != amount) {
+            EXPECT_LE(minChunkSize, end - begin);
+            EXPECT_GE(previousSize, end - begin);
+        }
+        previousSize = end - begin;
+        expectedBegin = end;
+    }
+    EXPECT_EQ(amount, expectedBegin);
+    EXPECT_FALSE(cursor.next(begin, end));
+}
+
+TEST_F(TasksClusteredRunTest, clusteredRunOnBorrowedMemory)
+{
+    const int n = 1000;
+    std::vector<int> input(n);
+    for (int i = 0; i < n; ++i)
+        input[static_cast<size_t>(i)] = i;
+    std::vector<long long> output(n, -1);
+    TestFuture<bool> future = clusteredRun(
+        input.data(), n, output.data(), [](int x) { return x * 2ll; }, 10);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_TRUE(future.result());
+    for (int i = 0; i < n; ++i)
+        EXPECT_EQ(i * 2ll, output[static_cast<size_t>(i)]);
+}
+
+TEST_F(TasksClusteredRunTest, clusteredRunOnBorrowedMemoryWithFailure)
+{
+    const int n = 100;
+    std::vector<int> input(n);
+    for (int i = 0; i < n; ++i)
+        input[static_cast<size_t>(i)] = i;
+    std::vector<int> output(n, -1);
+    TestFuture<bool> future = clusteredRun(
+        input.data(), n, output.data(),
+        [](int x) -> int {
+            if (x == 42)
+                return WithTestFailure("failed");
+            return x * 2;
+        },
+        5, TaskType::Custom);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(TasksClusteredRunTest, clusteredRunOnEmptyBorrowedMemory)
+{
+    int output = -1;
+    TestFuture<bool> future = clusteredRun(
+        static_cast<const int *>(nullptr), 0, &output, [](int x) { return x; });
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(-1, output);
+}
+
+TEST_F(TasksClusteredRunTest, parallelFor)
+{
+    const int64_t begin = 100;
+    const int64_t end = 1100;
+    std::vector<std::atomic_int> visits(static_cast<size_t>(end));
+    TestFuture<bool> future = parallelFor(
+        begin, end, 16, [&visits](int64_t i) { ++visits[static_cast<size_t>(i)]; }, TaskType::Custom);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    for (int64_t i = 0; i < end; ++i)
+        EXPECT_EQ(i < begin ? 0 : 1, visits[static_cast<size_t>(i)]) << i;
+}
+
+TEST_F(TasksClusteredRunTest, parallelForWithException)
+{
+    std::atomic_int visited{0};
+    TestFuture<bool> future = parallelFor(0, 100, 1, [&visited](int64_t i) {
+        ++visited;
+        if (i == 10)
+            throw std::runtime_error("Hi");
+    });
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Hi", future.failureReason());
+    EXPECT_GE(100, visited);
+}
+
+TEST_F(TasksClusteredRunTest, parallelForWithEmptyRange)
+{
+    bool called = false;
+    TestFuture<bool> future = parallelFor(10, 10, 1, [&called](int64_t) { called = true; });
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    future = parallelFor(10, 5, 1, [&called](int64_t) { called = true; });
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_FALSE(called);
+}
+
+TEST_F(TasksClusteredRunTest, clusteredReduce)
+{
+    std::vector<int> input;
+    for (int i = 0; i < 10000; ++i)
+        input.push_back(i);
+    TestFuture<long long> future = clusteredReduce(
+        input, [](int x) { return static_cast<long long>(x) * x; }, [](long long a, long long b) { return a + b; },
+        0ll, 10);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    long long expected = 0;
+    for (int x : input)
+        expected += static_cast<long long>(x) * x;
+    EXPECT_EQ(expected, future.result());
+}
+
+TEST_F(TasksClusteredRunTest, clusteredReduceKeepsOrder)
+{
+    std::vector<int> input;
+    std::string expected;
+    for (int i = 0; i < 3000; ++i) {
+        input.push_back(i % 10);
+        expected += std::to_string(i % 10);
+    }
+    for (int clusterSize : {1, 7, 100, 5000}) {
+        TestFuture<std::string> future = clusteredReduce(
+            input, [](int x) { return std::to_string(x); },
+            [](std::string a, const std::string &b) { return std::move(a) + b; }, std::string(), clusterSize,
+            TaskType::Custom);
+        future.wait(10000);
+        ASSERT_TRUE(future.isCompleted()) << clusterSize;
+        ASSERT_TRUE(future.isSucceeded()) << clusterSize;
+        EXPECT_EQ(expected, future.result()) << clusterSize;
+    }
+}
+
+TEST_F(TasksClusteredRunTest, clusteredReduceWithFailure)
+{
+    std::vector<int> input;
+    for (int i = 0; i < 1000; ++i)
+        input.push_back(i);
+    TestFuture<int> future = clusteredReduce(
+        input,
+        [](int x) -> int {
+            if (x == 500)
+                return WithTestFailure("failed");
+            return x;
+        },
+        [](int a, int b) { return a + b; }, 0, 5);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(TasksClusteredRunTest, clusteredReduceWithExceptionInCombine)
+{
+    std::vector<int> input;
+    for (int i = 0; i < 1000; ++i)
+        input.push_back(i);
+    TestFuture<int> future = clusteredReduce(
+        input, [](int x) { return x; },
+        [](int a, int b) {
+            if (a > 100000)
+                throw std::runtime_error("Hi");
+            return a + b;
+        },
+        0, 5);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Hi", future.failureReason());
+}
+
+TEST_F(TasksClusteredRunTest, clusteredReduceWithExceptionInAccCopy)
+{
+    struct ThrowingAcc
+    {
+        ThrowingAcc(int value = 0) : value(value) {}
+        ThrowingAcc(const ThrowingAcc &) { throw std::runtime_error("Copy"); }
+        ThrowingAcc(ThrowingAcc &&) noexcept = default;
+        ThrowingAcc &operator=(const ThrowingAcc &) = default;
+        ThrowingAcc &operator=(ThrowingAcc &&) noexcept = default;
+        int value;
+    };
+    std::vector<int> input;
+    for (int i = 0; i < 100; ++i)
+        input.push_back(i);
+    TestFuture<ThrowingAcc> future = clusteredReduce(
+        input, [](int x) { return ThrowingAcc(x); },
+        [](ThrowingAcc a, ThrowingAcc b) { return ThrowingAcc(a.value + b.value); }, ThrowingAcc(), 5);
+    future.wait(10000);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Copy", future.failureReason());
+}
+
+TEST_F(TasksClusteredRunTest, emptyClusteredReduce)
+{
+    TestFuture<int> future = clusteredReduce(
+        std::vector<int>(), [](int x) { return x; }, [](int a, int b) { return a + b; }, 42);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, future.result());
+}
@@ -0,0 +1,132 @@
+#include "tasksbasetest.h"
+
+#include <thread>
+
+class TasksContinuationsTest : public TasksBaseTest
+{};
+
+TEST_F(TasksContinuationsTest, mapOn)
+{
+    TestPromise<int> promise;
+    TestFuture<TasksTestResult<int>> future = promise.future().mapOn([](int x) { return pairedResult(x * 2); });
+    promise.success(21);
+    future.wait(10s);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_NE(currentThread(), future.result().first);
+    EXPECT_EQ(42, future.result().second);
+}
+
+TEST_F(TasksContinuationsTest, mapOnCompleted)
+{
+    TestFuture<TasksTestResult<int>> future = TestFuture<int>::successful(21).mapOn(
+        [](int x) { return pairedResult(x * 2); }, TaskType::Custom);
+    future.wait(10s);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_NE(currentThread(), future.result().first);
+    EXPECT_EQ(42, future.result().second);
+}
+
+TEST_F(TasksContinuationsTest, mapOnFailed)
+{
+    TestPromise<int> promise;
+    std::atomic_bool called{false};
+    TestFuture<int> future = promise.future().mapOn([&called](int x) {
+        called = true;
+        return x;
+    });
+    promise.failure("failed");
+    future.wait(10s);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+    EXPECT_FALSE(called);
+}
+
+TEST_F(TasksContinuationsTest, mapOnException)
+{
+    TestPromise<int> promise;
+    TestFuture<int> future = promise.future().mapOn([](int) -> int { throw std::runtime_error("Hello World"); });
+    promise.success(42);
+    future.wait(10s);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Hello World", future.failureReason());
+}
+
+TEST_F(TasksContinuationsTest, mapOnSameSubPoolIsInline)
+{
+    TestPromise<int> promise;
+    TestFuture<TasksTestResult<int>> future = promise.future().mapOn([](int x) { return pairedResult(x); },
+                                                                     TaskType::Intensive);
+    TestFuture<std::thread::id> task = run([promise]() {
+        promise.success(42);
+        return currentThread();
+    });
+    task.wait(10s);
+    future.wait(10s);
+    ASSERT_TRUE(task.isSucceeded());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(task.result(), future.result().first);
+    EXPECT_EQ(42, future.result().second);
+}
+
+TEST_F(TasksContinuationsTest, flatMapOn)
+{
+    TestPromise<int> promise;
+    TestPromise<int> innerPromise;
+    std::atomic<std::thread::id> calledIn{};
+    TestFuture<int> future = promise.future().flatMapOn(
+        [innerPromise, &calledIn](int) {
+            calledIn = currentThread();
+            return innerPromise.future();
+        },
+        TaskType::Custom);
+    promise.success(21);
+    innerPromise.success(42);
+    future.wait(10s);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, future.result());
+    EXPECT_NE(currentThread(), calledIn.load());
+}
+
+TEST_F(TasksContinuationsTest, onSuccessOn)
+{
+    TestPromise<int> promise;
+    TestPromise<TasksTestResult<int>> calledPromise;
+    TestFuture<int> future = promise.future().onSuccessOn(
+        [calledPromise](int x) { calledPromise.success(pairedResult(x)); }, TaskType::Custom, 0,
+        TaskPriority::Emergency);
+    promise.success(42);
+    EXPECT_EQ(future, promise.future());
+    TestFuture<TasksTestResult<int>> called = calledPromise.future();
+    called.wait(10s);
+    ASSERT_TRUE(called.isSucceeded());
+    EXPECT_NE(currentThread(), called.result().first);
+    EXPECT_EQ(42, called.result().second);
+}
+
+TEST_F(TasksContinuationsTest, onSuccessOnFailed)
+{
+    TestPromise<int> promise;
+    std::atomic_bool called{false};
+    TestFuture<int> future = promise.future().onSuccessOn([&called](int) { called = true; });
+    promise.failure("failed");
+    ASSERT_TRUE(future.isFailed());
+    std::this_thread::sleep_for(50ms);
+    EXPECT_FALSE(called);
+}
+
+TEST_F(TasksContinuationsTest, cancelableMapOn)
+{
+    TestPromise<int> promise;
+    CancelableTestFuture<int> cancelable(promise);
+    TestFuture<TasksTestResult<int>> future = cancelable.mapOn([](int x) { return pairedResult(x); });
+    promise.success(42);
+    future.wait(10s);
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_NE(currentThread(), future.result().first);
+    EXPECT_EQ(42, future.result().second);
+}
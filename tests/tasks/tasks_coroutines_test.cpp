@@ -0,0 +1,229 @@
+#include "tasksbasetest.h"
+
+#ifdef ASYNQRO_COROUTINES_SUPPORT
+
+#    include <thread>
+
+class TasksCoroutinesTest : public TasksBaseTest
+{};
+
+TestFuture<int> sumOf(TestFuture<int> left, TestFuture<int> right)
+{
+    int x = co_await left;
+    int y = co_await right;
+    co_return x + y;
+}
+
+TestFuture<int> chainedSum(int depth, TestFuture<int> base)
+{
+    if (!depth)
+        co_return co_await base;
+    int x = co_await chainedSum(depth - 1, base);
+    co_return x + 1;
+}
+
+TEST_F(TasksCoroutinesTest, completedAwaits)
+{
+    TestFuture<int> future = sumOf(TestFuture<int>::successful(20), TestFuture<int>::successful(22));
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(TasksCoroutinesTest, pendingAwaits)
+{
+    TestPromise<int> left;
+    TestPromise<int> right;
+    TestFuture<int> future = sumOf(left.future(), right.future());
+    EXPECT_FALSE(future.isCompleted());
+    right.success(22);
+    EXPECT_FALSE(future.isCompleted());
+    left.success(20);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(TasksCoroutinesTest, failedAwait)
+{
+    TestPromise<int> left;
+    std::atomic_bool resumed{false};
+    auto coroutine = [&resumed](TestFuture<int> f) -> TestFuture<int> {
+        int x = co_await f;
+        resumed = true;
+        co_return x;
+    };
+    TestFuture<int> future = coroutine(left.future());
+    left.failure("failed");
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+    EXPECT_FALSE(resumed);
+}
+
+TEST_F(TasksCoroutinesTest, withFailure)
+{
+    auto coroutine = [](TestFuture<int> f) -> TestFuture<int> {
+        int x = co_await f;
+        if (x > 0)
+            co_return WithTestFailure("positive");
+        co_return x;
+    };
+    TestFuture<int> future = coroutine(TestFuture<int>::successful(5));
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("positive", future.failureReason());
+    future = coroutine(TestFuture<int>::successful(-5));
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(-5, future.result());
+}
+
+TEST_F(TasksCoroutinesTest, exception)
+{
+    auto coroutine = [](TestFuture<int> f) -> TestFuture<int> {
+        int x = co_await f;
+        if (x > 0)
+            throw std::runtime_error("Hi");
+        co_return x;
+    };
+    TestFuture<int> future = coroutine(TestFuture<int>::successful(5));
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("Exception: Hi", future.failureReason());
+}
+
+TEST_F(TasksCoroutinesTest, failureConversion)
+{
+    auto coroutine = [](Future<int, const char *> f) -> TestFuture<int> { co_return co_await f; };
+    TestFuture<int> future = coroutine(Future<int, const char *>::failed("failed"));
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("failed", future.failureReason());
+}
+
+TEST_F(TasksCoroutinesTest, cancelableCoroutine)
+{
+    TestPromise<int> first;
+    TestPromise<int> second;
+    std::atomic_int resumed{0};
+    auto coroutine = [&resumed](TestFuture<int> a, TestFuture<int> b) -> CancelableTestFuture<int> {
+        int x = co_await a;
+        ++resumed;
+        int y = co_await b;
+        ++resumed;
+        co_return x + y;
+    };
+    CancelableTestFuture<int> future = coroutine(first.future(), second.future());
+    first.success(1);
+    EXPECT_EQ(1, resumed);
+    future.cancel();
+    second.success(2);
+    EXPECT_EQ(1, resumed);
+    ASSERT_TRUE(future.isCompleted());
+    ASSERT_TRUE(future.isFailed());
+    EXPECT_EQ("Canceled", future.failureReason());
+}
+
+TEST_F(TasksCoroutinesTest, awaitCancelable)
+{
+    auto coroutine = [](CancelableTestFuture<int> f) -> TestFuture<int> { co_return co_await f; };
+    TestPromise<int> promise;
+    TestFuture<int> future = coroutine(CancelableTestFuture<int>(promise));
+    promise.success(42);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(TasksCoroutinesTest, abandonedAwait)
+{
+    bool destroyed = false;
+    struct Witness
+    {
+        bool *destroyed;
+        ~Witness() { *destroyed = true; }
+    };
+    // Awaited future is not stored in coroutine frame, so nothing keeps it alive except promise
+    auto coroutine = [](const TestPromise<int> *promise, bool *destroyed) -> TestFuture<int> {
+        Witness witness{destroyed};
+        co_return co_await promise->future();
+    };
+    TestFuture<int> future;
+    {
+        TestPromise<int> promise;
+        future = coroutine(&promise, &destroyed);
+    }
+    EXPECT_FALSE(future.isCompleted());
+    EXPECT_FALSE(destroyed);
+    future = TestFuture<int>();
+    EXPECT_TRUE(destroyed);
+}
+
+TEST_F(TasksCoroutinesTest, deepChain)
+{
+    TestPromise<int> promise;
+    TestFuture<int> future = chainedSum(10000, promise.future());
+    EXPECT_FALSE(future.isCompleted());
+    promise.success(0);
+    ASSERT_TRUE(future.wait(10s));
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(10000, future.result());
+}
+
+TEST_F(TasksCoroutinesTest, singleAllocation)
+{
+    TestFuture<int> left = TestFuture<int>::successful(20);
+    TestFuture<int> right = TestFuture<int>::successful(22);
+    auto allocationsBefore = instantPooledAllocations() + instantNonPooledAllocations();
+    TestFuture<int> future = sumOf(left, right);
+    auto allocationsAfter = instantPooledAllocations() + instantNonPooledAllocations();
+    EXPECT_EQ(1, allocationsAfter - allocationsBefore);
+    EXPECT_EQ(42, future.result());
+}
+
+TEST_F(TasksCoroutinesTest, resumeOn)
+{
+    auto coroutine = []() -> TestFuture<TasksTestResult<int>> {
+        auto before = currentThread();
+        co_await resumeOn(TaskType::Custom, 5);
+        EXPECT_NE(before, currentThread());
+        co_return pairedResult(42);
+    };
+    auto future = coroutine();
+    ASSERT_TRUE(future.wait(10s));
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_NE(currentThread(), future.result().first);
+    EXPECT_EQ(42, future.result().second);
+}
+
+TEST_F(TasksCoroutinesTest, resumeOnSameSubPool)
+{
+    auto coroutine = []() -> TestFuture<bool> {
+        co_await resumeOn(TaskType::Custom, 5);
+        auto before = currentThread();
+        co_await resumeOn(TaskType::Custom, 5);
+        co_return before == currentThread();
+    };
+    auto future = coroutine();
+    ASSERT_TRUE(future.wait(10s));
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_TRUE(future.result());
+}
+
+TEST_F(TasksCoroutinesTest, resumeOnWithAwaits)
+{
+    auto coroutine = [](TestFuture<int> f) -> TestFuture<int> {
+        co_await resumeOn();
+        int x = co_await f;
+        co_await resumeOn(TaskType::Custom, 1);
+        co_return x * 2;
+    };
+    TestPromise<int> promise;
+    auto future = coroutine(promise.future());
+    promise.success(21);
+    ASSERT_TRUE(future.wait(10s));
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(42, future.result());
+}
+
+#endif
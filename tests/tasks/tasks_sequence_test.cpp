@@ -1,6 +1,7 @@
 #include "tasksbasetest.h"
 
 #include <chrono>
+#include <memory>
 
 using namespace std::chrono_literals;
 
@@ -281,3 +282,70 @@ TEST_F(TasksSequenceRunTest, sequenceRunWithFailure)
         ;
     EXPECT_EQ(n, doneCount);
 }
+
+TEST_F(TasksSequenceRunTest, runBatch)
+{
+    const int n = 1000;
+    std::vector<std::function<int()>> tasks;
+    for (int i = 0; i < n; ++i)
+        tasks.emplace_back([i]() { return i * 2; });
+    std::vector<CancelableTestFuture<int>> futures = runBatch(tasks);
+    ASSERT_EQ(n, futures.size());
+    for (int i = 0; i < n; ++i) {
+        futures[static_cast<size_t>(i)].wait(10000);
+        ASSERT_TRUE(futures[static_cast<size_t>(i)].isSucceeded());
+        EXPECT_EQ(i * 2, futures[static_cast<size_t>(i)].result());
+    }
+}
+
+TEST_F(TasksSequenceRunTest, runBatchWithMoveOnlyTasks)
+{
+    const int n = 10;
+    auto task = [](int i) { return [x = std::make_unique<int>(i)]() { return *x * 2; }; };
+    std::vector<decltype(task(0))> tasks;
+    for (int i = 0; i < n; ++i)
+        tasks.push_back(task(i));
+    auto futures = runBatch(std::move(tasks), TaskType::Custom);
+    ASSERT_EQ(n, futures.size());
+    for (int i = 0; i < n; ++i) {
+        futures[static_cast<size_t>(i)].wait(10000);
+        ASSERT_TRUE(futures[static_cast<size_t>(i)].isSucceeded());
+        EXPECT_EQ(i * 2, futures[static_cast<size_t>(i)].result());
+    }
+}
+
+TEST_F(TasksSequenceRunTest, runBatchRespectsSubPoolCapacity)
+{
+    const int32_t tag = 73;
+    const int capacity = 2;
+    const int n = 10;
+    TasksDispatcher::instance()->addCustomTag(tag, capacity);
+    std::atomic_bool ready{false};
+    std::atomic_int runCounter{0};
+    std::vector<std::function<void()>> tasks;
+    for (int i = 0; i < n; ++i) {
+        tasks.emplace_back([&ready, &runCounter]() {
+            ++runCounter;
+            while (!ready)
+                std::this_thread::sleep_for(1ms);
+        });
+    }
+    auto futures = runBatch(tasks, TaskType::Custom, tag);
+    auto timeout = std::chrono::high_resolution_clock::now() + 10s;
+    while (runCounter < capacity && std::chrono::high_resolution_clock::now() < timeout)
+        ;
+    std::this_thread::sleep_for(25ms);
+    EXPECT_EQ(capacity, runCounter);
+    ready = true;
+    for (const auto &future : futures) {
+        future.wait(10000);
+        EXPECT_TRUE(future.isSucceeded());
+    }
+    EXPECT_EQ(n, runCounter);
+}
+
+TEST_F(TasksSequenceRunTest, emptyRunBatch)
+{
+    auto futures = runBatch(std::vector<std::function<int()>>());
+    EXPECT_TRUE(futures.empty());
+}
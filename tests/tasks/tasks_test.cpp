@@ -1,14 +1,13 @@
 #include "tasksbasetest.h"
 
 #include <chrono>
+#include <memory>
 
 using namespace std::chrono_literals;
 
 class TasksTest : public TasksBaseTest
 {};
 
-using TasksDeathTest = TasksTest;
-
 struct ConvertingRunnerInfo
 {
     using PlainFailure = int;
@@ -143,6 +142,56 @@ TEST_F(TasksTest, singleRunAndForgetTask)
     EXPECT_EQ(42, result.second);
 }
 
+TEST_F(TasksTest, singleTaskWithMoveOnlyCapture)
+{
+    auto value = std::make_unique<int>(42);
+    TestFuture<int> result = run([value = std::move(value)]() { return *value; });
+    result.wait(10s);
+    ASSERT_TRUE(result.isCompleted());
+    EXPECT_TRUE(result.isSucceeded());
+    EXPECT_EQ(42, result.result());
+}
+
+TEST_F(TasksTest, singleRunAndForgetTaskWithMoveOnlyCapture)
+{
+    TestPromise<int> p;
+    auto value = std::make_unique<int>(42);
+    runAndForget([p, value = std::move(value)]() mutable {
+        auto local = std::move(value);
+        p.success(*local);
+    });
+    auto f = p.future();
+    f.wait(10s);
+    ASSERT_TRUE(f.isCompleted());
+    EXPECT_TRUE(f.isSucceeded());
+    EXPECT_EQ(42, f.result());
+}
+
+TEST_F(TasksTest, singleTaskSingleAllocation)
+{
+    // Dispatcher and worker are created on first run, they are not part of task cost
+    ASSERT_TRUE(run([]() {}).wait(10s));
+    auto allocationsBefore = instantPooledAllocations() + instantNonPooledAllocations();
+    TestFuture<int> result = run([]() { return 42; });
+    auto allocationsAfter = instantPooledAllocations() + instantNonPooledAllocations();
+    EXPECT_EQ(1, allocationsAfter - allocationsBefore);
+    ASSERT_TRUE(result.wait(10s));
+    EXPECT_EQ(42, result.result());
+}
+
+TEST_F(TasksTest, taskCapturesReleasedAfterRun)
+{
+    auto value = std::make_shared<int>(42);
+    std::weak_ptr<int> weakValue = value;
+    TestFuture<int> result = run([value = std::move(value)]() { return *value; });
+    ASSERT_TRUE(result.wait(10s));
+    EXPECT_EQ(42, result.result());
+    auto timeout = std::chrono::high_resolution_clock::now() + 10s;
+    while (std::chrono::high_resolution_clock::now() < timeout && !weakValue.expired())
+        std::this_thread::yield();
+    EXPECT_TRUE(weakValue.expired());
+}
+
 TEST_F(TasksTest, taskCancelation)
 {
     TasksDispatcher::instance()->addCustomTag(11, 1);
@@ -274,6 +323,9 @@ TEST_F(TasksTest, singleDeferredTaskFailureWithCastedFailure)
 
 TEST_F(TasksTest, multipleTasks)
 {
+    // Stolen tasks are not pinned to workers at submission, so each of them is not guaranteed to get its own thread
+    if (TasksDispatcher::instance()->workStealingEnabled())
+        GTEST_SKIP();
     std::atomic_bool ready{false};
     int n = 5;
     std::vector<TestFuture<TasksTestResult<int>>> results;
@@ -619,12 +671,12 @@ TestFuture<int> deepRecursionTrampolined(int step, int limit)
 
 constexpr int DEEP_RECURSION_LIMIT = 300000;
 
-TEST_F(TasksDeathTest, deepRecursionNoTrampoline)
+TEST_F(TasksTest, deepRecursionNoTrampoline)
 {
-#ifndef ASYNQRO_GCOV_ENABLED
-    testing::FLAGS_gtest_death_test_style = "threadsafe";
-    EXPECT_DEATH(deepRecursion(0, DEEP_RECURSION_LIMIT).wait(), ".*");
-#endif
+    auto f = deepRecursion(0, DEEP_RECURSION_LIMIT);
+    ASSERT_TRUE(f.wait(60000));
+    ASSERT_TRUE(f.isSucceeded());
+    EXPECT_EQ(DEEP_RECURSION_LIMIT, f.result());
 }
 
 TEST_F(TasksTest, deepRecursionWithTrampoline)
@@ -209,3 +209,36 @@ TEST_F(TasksThreadBoundTest, threadBindingToDifferentKeysAmongOtherTasks)
         ASSERT_TRUE(r.isCompleted() && r.isSucceeded()) << i << "; " << r.isCompleted() << "; " << r.isSucceeded();
     }
 }
+
+TEST_F(TasksThreadBoundTest, mapOnThreadBound)
+{
+    TestFuture<std::thread::id> boundThread = run([]() { return currentThread(); }, TaskType::ThreadBound, 42);
+    boundThread.wait(10s);
+    ASSERT_TRUE(boundThread.isSucceeded());
+
+    TestPromise<int> promise;
+    TestFuture<TasksTestResult<int>> future = promise.future().mapOn([](int x) { return pairedResult(x); },
+                                                                     TaskType::ThreadBound, 42);
+    promise.success(21);
+    future.wait(10s);
+    ASSERT_TRUE(future.isSucceeded());
+    EXPECT_EQ(boundThread.result(), future.result().first);
+    EXPECT_EQ(21, future.result().second);
+}
+
+TEST_F(TasksThreadBoundTest, runBatchThreadBound)
+{
+    const int n = 50;
+    std::vector<std::function<std::thread::id()>> tasks;
+    for (int i = 0; i < n; ++i)
+        tasks.emplace_back([]() { return currentThread(); });
+    auto futures = runBatch(tasks, TaskType::ThreadBound, 74);
+    futures.front().wait(10000);
+    ASSERT_TRUE(futures.front().isSucceeded());
+    std::thread::id boundThread = futures.front().result();
+    for (const auto &future : futures) {
+        future.wait(10000);
+        ASSERT_TRUE(future.isSucceeded());
+        EXPECT_EQ(boundThread, future.result());
+    }
+}
@@ -0,0 +1,196 @@
+#include "tasksbasetest.h"
+
+#include <chrono>
+#include <thread>
+
+using namespace std::chrono_literals;
+
+class TasksWorkStealingTest : public TasksBaseTest
+{
+protected:
+    void SetUp() override
+    {
+        TasksBaseTest::SetUp();
+        wasEnabled = TasksDispatcher::instance()->workStealingEnabled();
+        TasksDispatcher::instance()->setWorkStealingEnabled(true);
+    }
+    void TearDown() override
+    {
+        TasksBaseTest::TearDown();
+        TasksDispatcher::instance()->setWorkStealingEnabled(wasEnabled);
+    }
+
+    bool wasEnabled = false;
+};
+
+TEST_F(TasksWorkStealingTest, toggle)
+{
+    auto dispatcher = TasksDispatcher::instance();
+    EXPECT_TRUE(dispatcher->workStealingEnabled());
+    dispatcher->setWorkStealingEnabled(false);
+    EXPECT_FALSE(dispatcher->workStealingEnabled());
+    dispatcher->setWorkStealingEnabled(true);
+    EXPECT_TRUE(dispatcher->workStealingEnabled());
+}
+
+TEST_F(TasksWorkStealingTest, multipleTasks)
+{
+    int n = 1000;
+    std::vector<TestFuture<int>> results;
+    for (int i = 0; i < n; ++i) {
+        results.push_back(run([i]() { return i * 2; }, i % 2 ? TaskType::Intensive : TaskType::Custom));
+    }
+    for (int i = 0; i < n; ++i) {
+        results[static_cast<size_t>(i)].wait(10s);
+        ASSERT_TRUE(results[static_cast<size_t>(i)].isSucceeded());
+        EXPECT_EQ(i * 2, results[static_cast<size_t>(i)].result());
+    }
+}
+
+TEST_F(TasksWorkStealingTest, nestedTasks)
+{
+    int n = 100;
+    int m = 100;
+    std::atomic_int counter{0};
+    std::vector<TestFuture<bool>> results;
+    for (int i = 0; i < n; ++i) {
+        results.push_back(run([m, &counter]() {
+            std::vector<TestFuture<bool>> innerResults;
+            for (int j = 0; j < m; ++j)
+                innerResults.push_back(run([&counter]() { ++counter; }, TaskType::Intensive));
+            return TestFuture<bool>::sequence(innerResults).map([](const auto &) { return true; });
+        }));
+    }
+    for (int i = 0; i < n; ++i) {
+        results[static_cast<size_t>(i)].wait(10s);
+        ASSERT_TRUE(results[static_cast<size_t>(i)].isSucceeded());
+    }
+    EXPECT_EQ(n * m, counter);
+}
+
+TEST_F(TasksWorkStealingTest, intensiveCapacity)
+{
+    std::atomic_bool ready{false};
+    std::atomic_int runCounter{0};
+    int capacity = TasksDispatcher::instance()->subPoolCapacity(TaskType::Intensive);
+    int n = capacity * 2;
+    std::vector<TestFuture<int>> results;
+    for (int i = 0; i < n; ++i) {
+        results.push_back(run(
+            [&ready, &runCounter, i]() {
+                ++runCounter;
+                while (!ready)
+                    std::this_thread::sleep_for(1ms);
+                return i * 2;
+            },
+            TaskType::Intensive));
+    }
+    auto timeout = std::chrono::high_resolution_clock::now() + 10s;
+    while (runCounter < capacity && std::chrono::high_resolution_clock::now() < timeout)
+        ;
+    std::this_thread::sleep_for(25ms);
+    EXPECT_EQ(capacity, runCounter);
+    auto highPriority = run([]() { return 42; }, TaskType::Intensive, 0, TaskPriority::Emergency);
+    auto custom = run([]() { return 24; }, TaskType::Custom);
+    custom.wait(10s);
+    ASSERT_TRUE(custom.isSucceeded());
+    EXPECT_EQ(24, custom.result());
+    EXPECT_FALSE(highPriority.isCompleted());
+    ready = true;
+    highPriority.wait(10s);
+    ASSERT_TRUE(highPriority.isSucceeded());
+    EXPECT_EQ(42, highPriority.result());
+    for (int i = 0; i < n; ++i) {
+        results[static_cast<size_t>(i)].wait(10s);
+        ASSERT_TRUE(results[static_cast<size_t>(i)].isSucceeded());
+        EXPECT_EQ(i * 2, results[static_cast<size_t>(i)].result());
+    }
+}
+
+TEST_F(TasksWorkStealingTest, taggedTasksKeepCapacity)
+{
+    std::atomic_bool ready{false};
+    std::atomic_int runCounter{0};
+    int capacity = 2;
+    TasksDispatcher::instance()->addCustomTag(43, capacity);
+    int n = capacity * 3;
+    std::vector<TestFuture<int>> results;
+    for (int i = 0; i < n; ++i) {
+        results.push_back(run(TaskType::Custom, 43, [&ready, &runCounter, i]() {
+            ++runCounter;
+            while (!ready)
+                std::this_thread::sleep_for(1ms);
+            return i * 2;
+        }));
+    }
+    auto timeout = std::chrono::high_resolution_clock::now() + 10s;
+    while (runCounter < capacity && std::chrono::high_resolution_clock::now() < timeout)
+        ;
+    std::this_thread::sleep_for(25ms);
+    EXPECT_EQ(capacity, runCounter);
+    ready = true;
+    for (int i = 0; i < n; ++i) {
+        results[static_cast<size_t>(i)].wait(10s);
+        ASSERT_TRUE(results[static_cast<size_t>(i)].isSucceeded());
+        EXPECT_EQ(i * 2, results[static_cast<size_t>(i)].result());
+    }
+}
+
+struct SpawnJob
+{
+    struct State
+    {
+        std::atomic_int counter{0};
+        int expected = 0;
+        TestPromise<bool> promise;
+    };
+    std::shared_ptr<State> state;
+    int level = 0;
+
+    void operator()() const
+    {
+        if (level > 1) {
+            runAndForget(SpawnJob{state, level - 1});
+            runAndForget(SpawnJob{state, level - 1});
+        }
+        if (++state->counter == state->expected)
+            state->promise.success(true);
+    }
+};
+
+TEST_F(TasksWorkStealingTest, spawnedTree)
+{
+    int depth = 10;
+    auto state = std::make_shared<SpawnJob::State>();
+    state->expected = (1 << depth) - 1;
+    runAndForget(SpawnJob{state, depth});
+    auto future = state->promise.future();
+    future.wait(10s);
+    ASSERT_TRUE(future.isCompleted());
+    EXPECT_EQ(state->expected, state->counter);
+}
+
+TEST_F(TasksWorkStealingTest, spawnedTaskIsStolenFromBusyWorker)
+{
+    std::atomic_bool childDone{false};
+    auto result = run(
+        [&childDone]() {
+            auto parentThread = currentThread();
+            auto child = run(
+                [&childDone]() {
+                    childDone = true;
+                    return currentThread();
+                },
+                TaskType::Custom);
+            auto timeout = std::chrono::high_resolution_clock::now() + 10s;
+            while (!childDone && std::chrono::high_resolution_clock::now() < timeout)
+                ;
+            child.wait(10s);
+            return child.isSucceeded() && child.result() != parentThread;
+        },
+        TaskType::Custom);
+    result.wait(15s);
+    ASSERT_TRUE(result.isSucceeded());
+    EXPECT_TRUE(childDone);
+    EXPECT_TRUE(result.result());
+}